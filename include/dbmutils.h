@@ -2,6 +2,8 @@
 #define DBM_UTILS_H
 
 struct Dbmw;
+struct DbmwTable;
+struct Fed;
 
 
 #include <stdint.h>
@@ -23,9 +25,12 @@ int dbmw_isSubsetEq(const struct Dbmw *, const struct Dbmw *);
 int dbmw_isSupersetEq(const struct Dbmw *, const struct Dbmw *);
 int dbmw_intersects(const struct Dbmw *, const struct Dbmw *);
 int dbmw_areEqual(const struct Dbmw *, const struct Dbmw *);
+uint32_t dbmw_hash(const struct Dbmw *);
 int dbmw_isEmpty(const struct Dbmw *);
 int dbmw_containsZero(const struct Dbmw *);
 int dbmw_isPointIncluded(const struct Dbmw *, const int32_t *);
+int dbmw_firstIncluding(const struct Dbmw *const *, unsigned int, const int32_t 
+		*);
 
 struct Dbmw *dbmw_reset(struct Dbmw *, struct Clock *);
 struct Dbmw *dbmw_constrainClock(struct Dbmw *, struct Clock *, int32_t);
@@ -36,8 +41,8 @@ struct Dbmw *dbmw_updateIncrementAll(struct Dbmw *, unsigned int);
 unsigned int dbmw_nextPoint(struct Dbmw *, const struct Dbmw *);
 unsigned int dbmw_distance(const int32_t *, const struct Dbmw *);
 
-struct List *dbmw_partition(const struct List *);
 struct Dbmw *dbmw_upTo(const struct Dbmw *, const struct Dbmw *);
+int dbmw_upToInto(struct Dbmw *, const struct Dbmw *, const struct Dbmw *);
 
 void dbmw_print(FILE *, const struct Dbmw *, struct Clock ** const);
 char *dbmw_sprint(const struct Dbmw *, struct Clock ** const);
@@ -46,9 +51,28 @@ void dbmw_save(const struct Dbmw *, FILE *);
 struct Dbmw *dbmw_load(FILE *);
 
 void dbmw_free(struct Dbmw *);
+void dbmw_releasePool(void);
 
-/* For debugging, should be static */
-struct List *dbmw_subtract(const struct Dbmw *, const struct Dbmw *);
+struct DbmwTable *dbmwTable_new(void);
+const struct Dbmw *dbmwTable_intern(struct DbmwTable *, struct Dbmw *);
+const struct Dbmw *dbmwTable_ref(struct DbmwTable *, const struct Dbmw *);
+void dbmwTable_release(struct DbmwTable *, const struct Dbmw *);
+unsigned int dbmwTable_size(const struct DbmwTable *);
+void dbmwTable_free(struct DbmwTable *);
+
+unsigned long dbmw_nbOps(void);
+
+struct Fed *fed_new(cindex_t dim);
+unsigned int fed_size(const struct Fed *);
+void fed_clear(struct Fed *);
+void fed_append(struct Fed *, const struct Dbmw *);
+void fed_union(struct Fed *, const struct Fed *);
+struct Dbmw *fed_getDbmw(const struct Fed *, unsigned int);
+void fed_intersect(struct Fed *, const struct Dbmw *);
+void fed_subtract(struct Fed *, const struct Dbmw *);
+void fed_partition(struct Fed *);
+void fed_mergeAdjacent(struct Fed *, const struct Fed *);
+void fed_free(struct Fed *);
 
 #endif
 
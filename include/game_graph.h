@@ -3,6 +3,7 @@
 
 #include <list.h>
 #include <stdio.h>
+#include <stddef.h>
 
 struct Node;
 struct Graph;
@@ -13,6 +14,8 @@ struct Enforcer;
 enum EdgeType {EMIT, STOPEMIT, CONTRCVD, UNCONTRCVD, TIMELPSD};
 enum Strat {STRAT_EMIT, STRAT_DONTEMIT};
 enum EnforcerMode {ENFORCERMODE_DEFAULT, ENFORCERMODE_FAST};
+/* Accepting condition of the game, which selects the solver */
+enum Objective {OBJECTIVE_BUCHI, OBJECTIVE_SAFETY, OBJECTIVE_COSAFETY};
 
 struct Edge
 {
@@ -31,9 +34,74 @@ struct Event
 	const char *label;
 };
 
+/* Greatest number of threads of struct GraphOptions */
+#define GRAPHOPTIONS_MAXTHREADS	256
+
+struct GraphOptions
+{
+	/* Number of threads used to build the graph, 0 for one per processor, at 
+	 * most GRAPHOPTIONS_MAXTHREADS */
+	unsigned int nbThreads;
+	/* Also split the zones in parallel during the zone graph refinement. The 
+	 * zone graph is the same as the sequential one. */
+	int parallelRefinement;
+	/* Only build and solve the nodes of the zones reachable from the initial 
+	 * zone, the only ones the enforcer can visit. The zone graph is still 
+	 * refined as a whole, before the game is built. */
+	int reachableOnly;
+};
+
+/* Phases of the construction of a graph */
+enum GraphPhase {GRAPHPHASE_PARSE, GRAPHPHASE_AUTOMATON, GRAPHPHASE_REFINEMENT, 
+	GRAPHPHASE_ZONESUCCS, GRAPHPHASE_STRINGS, GRAPHPHASE_NODES, GRAPHPHASE_EDGES, 
+	GRAPHPHASE_SOLVE, GRAPHPHASE_NB};
+
+struct GraphPhaseStats
+{
+	/* In seconds. The CPU time is the one of all the threads. */
+	double wallTime;
+	double cpuTime;
+	/* Operations on DBMs, on all the threads */
+	unsigned long nbDbmOps;
+	/* Bytes allocated at the end of the phase, 0 if unknown */
+	size_t allocatedBytes;
+};
+
+/* Statistics on the construction of a graph (all 0 for a loaded graph) */
+struct GraphStats
+{
+	struct GraphPhaseStats phases[GRAPHPHASE_NB];
+	/* Zones taken from the unstable set of the refinement, and split */
+	unsigned long nbRefineIterations;
+	unsigned long nbSplits;
+	unsigned int peakZones;
+	unsigned int nbZones;
+	/* DBMs of the zone graph, each stored once */
+	unsigned int nbDbms;
+	/* Distinct states of the buffer words */
+	unsigned int nbStrings;
+	unsigned int nbNodes;
+	enum Objective objective;
+	/* Components of the game graph, solved level by level (Buchi objective 
+	 * only) */
+	unsigned int nbSccs;
+	unsigned int nbSccLevels;
+	/* Greatest allocatedBytes of the phases. The allocations are only sampled 
+	 * at the end of each phase, so the peak within a phase may be higher. */
+	size_t maxPhaseEndAllocatedBytes;
+};
+
+void graphOptions_init(struct GraphOptions *);
+
 struct Graph *graph_newFromAutomaton(const char *filename);
+struct Graph *graph_newFromAutomatonOpts(const char *filename, const struct 
+		GraphOptions *);
+struct Graph *graph_updateFromAutomaton(const struct Graph *, const char 
+		*filename, const struct GraphOptions *);
 const struct List *graph_getNodes(const struct Graph *);
 const struct ZoneGraph *graph_getZoneGraph(const struct Graph *);
+const struct GraphStats *graph_getStats(const struct Graph *);
+void graphStats_print(const struct GraphStats *, FILE *);
 void graph_save(const struct Graph *, const char *);
 struct Graph *graph_load(const char *);
 void graph_free(struct Graph *);
@@ -48,7 +116,8 @@ int node_isWinning(const struct Node *);
 enum Strat node_strat(const struct Node *);
 void node_setData(struct Node *, void *);
 void *node_getData(const struct Node *);
-const struct List *node_edges(const struct Node *);
+unsigned int node_nbEdges(const struct Node *);
+struct Edge node_edge(const struct Node *, unsigned int);
 
 const struct List *zoneGraph_getZones(const struct ZoneGraph *);
 
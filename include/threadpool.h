@@ -0,0 +1,17 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+struct ThreadPool;
+
+/* f(arg, begin, end, worker) processes the indexes [begin, end) */
+typedef void (*ThreadPoolFunc)(void *, unsigned int, unsigned int, unsigned
+		int);
+
+struct ThreadPool *threadPool_new(unsigned int nbThreads);
+unsigned int threadPool_nbThreads(const struct ThreadPool *);
+void threadPool_run(struct ThreadPool *, unsigned int n, ThreadPoolFunc f, void
+		*arg);
+void threadPool_free(struct ThreadPool *);
+
+#endif
+
@@ -3,41 +3,444 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #include <dbm/constraints.h>
 #include <dbm/dbm.h>
 
-#include <list.h>
-#include <fifo.h>
 
 #include "clock.h"
 
+#define PARTITIONINDEX_INITSIZE	16
+/* Biggest dimension handled by the dbmSmall_* kernels (two clocks) */
+#define DBMW_SMALLDIM	3
+/* Dimensions whose Dbmws are recycled by the pools, and size of a free list */
+#define DBMWPOOL_MAXDIM	16
+#define DBMWPOOL_MAXFREE	4096
+/* Number of stripes of a DbmwTable, and initial number of buckets of each */
+#define DBMWTABLE_NBSTRIPES	64
+#define DBMWTABLE_INITSIZE	8
+#define FED_INITSIZE	8
+
 extern struct Clock **clocks;
 
+/* The matrix of a Dbmw allocated by dbmw_new follows the struct, in the same 
+ * block. dbm may also point to some other storage, e.g. on the stack. */
 struct Dbmw
 {
 	raw_t *dbm;
 	cindex_t dim;
+	/* Next Dbmw of the free list of a pool, or of a bucket of a DbmwTable */
+	struct Dbmw *next;
+	/* Number of references to the Dbmw, if it is interned in a DbmwTable. It 
+	 * is only accessed under the lock of the stripe of the table that holds 
+	 * the Dbmw. */
+	unsigned int refCount;
+	/* 1 if the Dbmw is interned, 0 otherwise. It is set with hash before the 
+	 * Dbmw is published in a table, and neither changes until it is freed, so 
+	 * that they may be read without any lock. */
+	int isInterned;
+	/* Hash of the matrix, if it is interned */
+	uint32_t hash;
+};
+
+/* Part of a DbmwTable: the DBMs whose hash is h are in the stripe of index 
+ * h % DBMWTABLE_NBSTRIPES, and in its bucket of index 
+ * (h / DBMWTABLE_NBSTRIPES) % nbBuckets */
+struct DbmwTableStripe
+{
+	struct Dbmw **buckets;
+	unsigned int nbBuckets;
+	unsigned int size;
+	pthread_mutex_t mutex;
+};
+
+/* Interned DBMs: each closed DBM is stored once, with a reference count. A 
+ * table may be used by several threads, which only contend when they access 
+ * the same stripe. */
+struct DbmwTable
+{
+	struct DbmwTableStripe stripes[DBMWTABLE_NBSTRIPES];
+};
+
+/* Free Dbmws of the calling thread, one list per dimension, recycled by 
+ * dbmw_new and released in bulk by dbmw_releasePool */
+struct DbmwPool
+{
+	struct Dbmw *free[DBMWPOOL_MAXDIM + 1];
+	unsigned int nbFree[DBMWPOOL_MAXDIM + 1];
 };
 
+/* Federation: a union of DBMs of the same dimension, stored one after the 
+ * other */
+struct Fed
+{
+	cindex_t dim;
+	unsigned int size;
+	unsigned int allocSize;
+	raw_t *dbms;
+};
+
+/* Pieces of the partition computed by fed_partition, in order, with their 
+ * bounding boxes (see dbmRaw_box). A removed piece is only marked as such. */
+struct PartitionIndex
+{
+	struct Fed *pieces;
+	raw_t *boxes;
+	unsigned char *removed;
+	unsigned int allocSize;
+	unsigned int nbRemoved;
+	/* Buffer for partitionIndex_findIntersecting */
+	raw_t *tmp;
+};
+
+/* Buffers of dbmw_subtractRaw, for DBMs of dimension at most allocDim */
+struct DbmwScratch
+{
+	cindex_t dim;
+	cindex_t allocDim;
+	raw_t *inter;
+	raw_t *remain;
+	uint32_t *minBits;
+	/* The pieces of the result, dim * dim each */
+	raw_t *pieces;
+};
+
+/* Number of udbm operations performed by the current thread */
+static __thread unsigned long nbOps = 0;
+/* Scratch storage of the current thread, see dbmwScratch_get */
+static __thread struct DbmwScratch *threadScratch = NULL;
+/* Pool of the current thread */
+static __thread struct DbmwPool dbmwPool;
+
+/*
+ * Kernels for DBMs of dimension 2 (one clock, the zone is an interval) and 3 
+ * (two clocks). They are always called with a constant dim, so that the 
+ * compiler unrolls their loops, and they give the same matrices as the generic 
+ * udbm functions. An empty DBM is marked as udbm does, with dbm[0] < 
+ * dbm_LE_ZERO.
+ */
+
+static inline int dbmSmall_close(raw_t *dbm, cindex_t dim)
+{
+	cindex_t i, j, k;
+
+	if (dim == 2)
+	{
+		if (dbm_addRawRaw(dbm[1], dbm[2]) < dbm_LE_ZERO)
+		{
+			dbm[0] = -1;
+			return 0;
+		}
+		return 1;
+	}
+
+	for (k = 0 ; k < dim ; k++)
+	{
+		for (i = 0 ; i < dim ; i++)
+		{
+			if (i == k || dbm[i * dim + k] == dbm_LS_INFINITY)
+				continue;
+			for (j = 0 ; j < dim ; j++)
+			{
+				raw_t r = dbm_addRawRaw(dbm[i * dim + k], dbm[k * dim + j]);
+				if (r < dbm[i * dim + j])
+					dbm[i * dim + j] = r;
+			}
+			if (dbm[i * dim + i] < dbm_LE_ZERO)
+			{
+				dbm[0] = -1;
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+static inline int dbmSmall_intersection(raw_t *dbm1, const raw_t *dbm2, 
+		cindex_t dim)
+{
+	cindex_t i;
+	int changed = 0;
+
+	if (dbm1[0] < dbm_LE_ZERO)
+		return 0;
+	if (dbm2[0] < dbm_LE_ZERO)
+	{
+		dbm1[0] = -1;
+		return 0;
+	}
+
+	for (i = 1 ; i < dim * dim ; i++)
+	{
+		if (dbm2[i] < dbm1[i])
+		{
+			dbm1[i] = dbm2[i];
+			changed = 1;
+		}
+	}
+
+	/* Both DBMs are closed, so dbm1 is still closed if nothing changed */
+	return !changed || dbmSmall_close(dbm1, dim);
+}
+
+static inline int dbmSmall_isSubsetEq(const raw_t *dbm1, const raw_t *dbm2, 
+		cindex_t dim)
+{
+	cindex_t i;
+
+	for (i = 0 ; i < dim * dim ; i++)
+	{
+		if (dbm1[i] > dbm2[i])
+			return 0;
+	}
+
+	return 1;
+}
+
+static inline void dbmSmall_up(raw_t *dbm, cindex_t dim)
+{
+	cindex_t i;
+
+	for (i = 1 ; i < dim ; i++)
+		dbm[i * dim] = dbm_LS_INFINITY;
+}
+
+/* The lower bound of x_j becomes the tightest of 0 and of the x_j - x_i */
+static inline void dbmSmall_down(raw_t *dbm, cindex_t dim)
+{
+	cindex_t i, j;
+
+	for (j = 1 ; j < dim ; j++)
+	{
+		dbm[j] = dbm_LE_ZERO;
+		for (i = 1 ; i < dim ; i++)
+		{
+			if (dbm[i * dim + j] < dbm[j])
+				dbm[j] = dbm[i * dim + j];
+		}
+	}
+}
+
+/* x_k := 0, i.e. x_k takes the constraints of the reference clock */
+static inline void dbmSmall_reset(raw_t *dbm, cindex_t dim, cindex_t k)
+{
+	cindex_t i;
+
+	for (i = 0 ; i < dim ; i++)
+	{
+		dbm[k * dim + i] = dbm[i];
+		dbm[i * dim + k] = dbm[i * dim];
+	}
+	dbm[k * dim + k] = dbm_LE_ZERO;
+}
+
+static inline int dbmSmall_isPointIncluded(const int32_t *val, const raw_t 
+		*dbm, cindex_t dim)
+{
+	cindex_t i, j;
+
+	for (i = 0 ; i < dim ; i++)
+	{
+		for (j = 0 ; j < dim ; j++)
+		{
+			if (i != j && dbm_bound2raw(val[i] - val[j], dbm_WEAK) > dbm[i * 
+					dim + j])
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+/*
+ * Kernels for the valuations of the enforcer. A valuation val is in a DBM iff 
+ * val[i] - val[j] <= dbm[i][j] for all i, j, i.e. iff the raw value of the 
+ * constraint val[i] - val[j] <= (val[i] - val[j]) is at most dbm[i][j]. They 
+ * use AVX2 or SSE2 when the compiler targets them (see --enable-avx2 in 
+ * configure.ac), and scalar loops otherwise. check_dbmutils compares them with 
+ * the scalar computations.
+ */
+
+/* Returns 1 iff raw(vi - val[j]) <= row[j] for all j < dim */
+static inline int dbmw_rowIncludes(const raw_t *row, int32_t vi, const int32_t 
+		*val, cindex_t dim)
+{
+	cindex_t j = 0;
+#if defined(__AVX2__)
+	const __m256i vi8 = _mm256_set1_epi32(vi), one8 = _mm256_set1_epi32(1);
+
+	for ( ; j + 8 <= dim ; j += 8)
+	{
+		__m256i d = _mm256_sub_epi32(vi8, _mm256_loadu_si256((const __m256i 
+						*)&(val[j])));
+		__m256i r = _mm256_or_si256(_mm256_slli_epi32(d, 1), one8);
+		if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(r, 
+						_mm256_loadu_si256((const __m256i *)&(row[j])))) != 0)
+			return 0;
+	}
+#endif
+#if defined(__SSE2__)
+	const __m128i vi4 = _mm_set1_epi32(vi), one4 = _mm_set1_epi32(1);
+
+	for ( ; j + 4 <= dim ; j += 4)
+	{
+		__m128i d = _mm_sub_epi32(vi4, _mm_loadu_si128((const __m128i 
+						*)&(val[j])));
+		__m128i r = _mm_or_si128(_mm_slli_epi32(d, 1), one4);
+		if (_mm_movemask_epi8(_mm_cmpgt_epi32(r, _mm_loadu_si128((const __m128i 
+								*)&(row[j])))) != 0)
+			return 0;
+	}
+#endif
+	for ( ; j < dim ; j++)
+	{
+		if (dbm_bound2raw(vi - val[j], dbm_WEAK) > row[j])
+			return 0;
+	}
+
+	return 1;
+}
+
+/* Returns 1 iff point[k] <= dbm[k] for all k < n */
+static inline int dbmw_coversPoint(const raw_t *dbm, const raw_t *point, 
+		cindex_t n)
+{
+	cindex_t k = 0;
+#if defined(__AVX2__)
+	for ( ; k + 8 <= n ; k += 8)
+	{
+		if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(_mm256_loadu_si256((const 
+								__m256i *)&(point[k])), 
+						_mm256_loadu_si256((const __m256i *)&(dbm[k])))) != 0)
+			return 0;
+	}
+#endif
+#if defined(__SSE2__)
+	for ( ; k + 4 <= n ; k += 4)
+	{
+		if (_mm_movemask_epi8(_mm_cmpgt_epi32(_mm_loadu_si128((const __m128i 
+								*)&(point[k])), _mm_loadu_si128((const __m128i 
+								*)&(dbm[k])))) != 0)
+			return 0;
+	}
+#endif
+	for ( ; k < n ; k++)
+	{
+		if (point[k] > dbm[k])
+			return 0;
+	}
+
+	return 1;
+}
+
+/* Returns max(0, max over 0 < i < dim of (lower bound of x_i) - val[i]), where 
+ * the lower bound is rounded to the next integer if it is strict */
+static inline int dbmw_maxLowerDistance(const raw_t *row0, const int32_t *val, 
+		cindex_t dim)
+{
+	cindex_t i = 1;
+	int max = 0;
+#if defined(__AVX2__)
+	__m256i max8 = _mm256_setzero_si256();
+	const __m256i one8 = _mm256_set1_epi32(1);
+
+	for ( ; i + 8 <= dim ; i += 8)
+	{
+		__m256i r = _mm256_loadu_si256((const __m256i *)&(row0[i]));
+		/* -bound - val + strict, with strict = 1 - (r & 1) */
+		__m256i d = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_setzero_si256(), 
+					_mm256_srai_epi32(r, 1)), _mm256_loadu_si256((const __m256i 
+						*)&(val[i])));
+		d = _mm256_add_epi32(d, _mm256_xor_si256(_mm256_and_si256(r, one8), 
+					one8));
+		max8 = _mm256_max_epi32(max8, d);
+	}
+	{
+		int32_t lanes[8];
+		int k;
+
+		_mm256_storeu_si256((__m256i *)lanes, max8);
+		for (k = 0 ; k < 8 ; k++)
+			max = (lanes[k] > max) ? lanes[k] : max;
+	}
+#endif
+#if defined(__SSE2__)
+	{
+		__m128i max4 = _mm_setzero_si128();
+		const __m128i one4 = _mm_set1_epi32(1);
+		int32_t lanes[4];
+		int k;
+
+		for ( ; i + 4 <= dim ; i += 4)
+		{
+			__m128i r = _mm_loadu_si128((const __m128i *)&(row0[i]));
+			__m128i d = _mm_sub_epi32(_mm_sub_epi32(_mm_setzero_si128(), 
+						_mm_srai_epi32(r, 1)), _mm_loadu_si128((const __m128i 
+							*)&(val[i])));
+			__m128i gt;
+
+			d = _mm_add_epi32(d, _mm_xor_si128(_mm_and_si128(r, one4), one4));
+			/* No _mm_max_epi32 before SSE4.1 */
+			gt = _mm_cmpgt_epi32(d, max4);
+			max4 = _mm_or_si128(_mm_and_si128(gt, d), _mm_andnot_si128(gt, 
+						max4));
+		}
+		_mm_storeu_si128((__m128i *)lanes, max4);
+		for (k = 0 ; k < 4 ; k++)
+			max = (lanes[k] > max) ? lanes[k] : max;
+	}
+#endif
+	for ( ; i < dim ; i++)
+	{
+		/* take the opposite of row0[i], since it is <= -c to say x >= c */
+		int d = -dbm_raw2bound(row0[i]) - val[i];
+		if (dbm_rawIsStrict(row0[i]))
+			d++;
+		max = (d > max) ? d : max;
+	}
+
+	return max;
+}
+
+/**
+ * The Dbmw is taken from the pool of the calling thread if it has one of this 
+ * dimension, otherwise the struct and its matrix are allocated in one block.
+ */
 struct Dbmw *dbmw_new(cindex_t dim)
 {
-	struct Dbmw *ret = malloc(sizeof *ret);
+	struct Dbmw *ret;
 	
-	if (ret == NULL)
+	if (dim <= DBMWPOOL_MAXDIM && dbmwPool.free[dim] != NULL)
 	{
-		perror("malloc dbmw");
-		exit(EXIT_FAILURE);
+		ret = dbmwPool.free[dim];
+		dbmwPool.free[dim] = ret->next;
+		dbmwPool.nbFree[dim]--;
 	}
-
-	ret->dim = dim;
-	ret->dbm = malloc(dim * dim * sizeof *(ret->dbm));
-	if (ret->dbm == NULL)
+	else
 	{
-		perror("malloc dbm");
-		exit(EXIT_FAILURE);
+		ret = malloc(sizeof *ret + dim * dim * sizeof *(ret->dbm));
+		if (ret == NULL)
+		{
+			perror("malloc dbmw");
+			exit(EXIT_FAILURE);
+		}
 	}
 
+	ret->dim = dim;
+	ret->dbm = (raw_t *)(ret + 1);
+	ret->next = NULL;
+	ret->refCount = 0;
+	ret->isInterned = 0;
+
+	nbOps++;
 	dbm_init(ret->dbm, ret->dim);
 
 	return ret;
@@ -46,6 +449,7 @@ struct Dbmw *dbmw_new(cindex_t dim)
 struct Dbmw *dbmw_newcp(const struct Dbmw *src)
 {
 	struct Dbmw *new = dbmw_new(src->dim);
+	nbOps++;
 	dbm_copy(new->dbm, src->dbm, new->dim);
 
 	return new;
@@ -53,6 +457,7 @@ struct Dbmw *dbmw_newcp(const struct Dbmw *src)
 
 struct Dbmw *dbmw_copy(struct Dbmw *dst, const struct Dbmw *src)
 {
+	nbOps++;
 	dbm_copy(dst->dbm, src->dbm, dst->dim);
 
 	return dst;
@@ -61,6 +466,7 @@ struct Dbmw *dbmw_copy(struct Dbmw *dst, const struct Dbmw *src)
 
 struct Dbmw *dbmw_zero(struct Dbmw *d)
 {
+	nbOps++;
 	dbm_zero(d->dbm, d->dim);
 
 	return d;
@@ -68,6 +474,7 @@ struct Dbmw *dbmw_zero(struct Dbmw *d)
 
 struct Dbmw *dbmw_init(struct Dbmw *d)
 {
+	nbOps++;
 	dbm_init(d->dbm, d->dim);
 
 	return d;
@@ -75,36 +482,102 @@ struct Dbmw *dbmw_init(struct Dbmw *d)
 
 struct Dbmw *dbmw_up(struct Dbmw *d)
 {
-	dbm_up(d->dbm, d->dim);
+	nbOps++;
+	switch (d->dim)
+	{
+		case 2:
+			dbmSmall_up(d->dbm, 2);
+		break;
+
+		case 3:
+			dbmSmall_up(d->dbm, 3);
+		break;
+
+		default:
+			dbm_up(d->dbm, d->dim);
+	}
 	return d;
 }
 
 struct Dbmw *dbmw_down(struct Dbmw *d)
 {
-	dbm_down(d->dbm, d->dim);
+	nbOps++;
+	switch (d->dim)
+	{
+		case 2:
+			dbmSmall_down(d->dbm, 2);
+		break;
+
+		case 3:
+			dbmSmall_down(d->dbm, 3);
+		break;
+
+		default:
+			dbm_down(d->dbm, d->dim);
+	}
 	return d;
 }
 
+static inline int dbmRaw_intersection(raw_t *dbm1, const raw_t *dbm2, cindex_t 
+		dim)
+{
+	switch (dim)
+	{
+		case 2:
+			return dbmSmall_intersection(dbm1, dbm2, 2);
+
+		case 3:
+			return dbmSmall_intersection(dbm1, dbm2, 3);
+
+		default:
+			return dbm_intersection(dbm1, dbm2, dim);
+	}
+}
+
 int dbmw_intersection(struct Dbmw *d1, const struct Dbmw *d2)
 {
-	return dbm_intersection(d1->dbm, d2->dbm, d1->dim);
+	nbOps++;
+	return dbmRaw_intersection(d1->dbm, d2->dbm, d1->dim);
 }
 
 int dbmw_isSubsetEq(const struct Dbmw *d1, const struct Dbmw *d2)
 {
-	return dbm_isSubsetEq(d1->dbm, d2->dbm, d1->dim);
+	nbOps++;
+	switch (d1->dim)
+	{
+		case 2:
+			return dbmSmall_isSubsetEq(d1->dbm, d2->dbm, 2);
+
+		case 3:
+			return dbmSmall_isSubsetEq(d1->dbm, d2->dbm, 3);
+
+		default:
+			return dbm_isSubsetEq(d1->dbm, d2->dbm, d1->dim);
+	}
 }
 
 int dbmw_isSupersetEq(const struct Dbmw *d1, const struct Dbmw *d2)
 {
-	return dbm_isSupersetEq(d1->dbm, d2->dbm, d1->dim);
+	return dbmw_isSubsetEq(d2, d1);
 }
 
+/* The copy of dbm1 is on the stack for the small dimensions */
 int dbmw_intersects(const struct Dbmw *dbm1, const struct Dbmw *dbm2)
 {
-	struct Dbmw *cp = dbmw_newcp(dbm1);
-	int ret = dbmw_intersection(cp, dbm2);
+	struct Dbmw *cp;
+	int ret;
+
+	if (dbm1->dim <= DBMW_SMALLDIM)
+	{
+		raw_t buf[DBMW_SMALLDIM * DBMW_SMALLDIM];
+		struct Dbmw small = {buf, dbm1->dim, NULL};
 
+		dbmw_copy(&small, dbm1);
+		return dbmw_intersection(&small, dbm2);
+	}
+
+	cp = dbmw_newcp(dbm1);
+	ret = dbmw_intersection(cp, dbm2);
 	dbmw_free(cp);
 
 	return ret;
@@ -112,34 +585,133 @@ int dbmw_intersects(const struct Dbmw *dbm1, const struct Dbmw *dbm2)
 
 int dbmw_areEqual(const struct Dbmw *dbm1, const struct Dbmw *dbm2)
 {
+	if (dbm1 == dbm2)
+		return 1;
+	if (dbm1->isInterned && dbm2->isInterned && dbm1->hash != dbm2->hash)
+		return 0;
+
+	nbOps++;
 	return (dbm1->dim == dbm2->dim && dbm_areEqual(dbm1->dbm, dbm2->dbm, 
 				dbm1->dim));
 }
 
+/**
+ * The DBMs are kept closed, so two equal zones have the same matrix and thus 
+ * the same hash. The hash of an interned DBM is computed only once.
+ */
+uint32_t dbmw_hash(const struct Dbmw *dbm)
+{
+	if (dbm->isInterned)
+		return dbm->hash;
+
+	nbOps++;
+	return dbm_hash(dbm->dbm, dbm->dim);
+}
+
 int dbmw_isEmpty(const struct Dbmw *dbm)
 {
+	nbOps++;
 	return dbm_isEmpty(dbm->dbm, dbm->dim);
 }
 
 int dbmw_containsZero(const struct Dbmw *dbm)
 {
+	nbOps++;
 	return dbm_hasZero(dbm->dbm, dbm->dim);
 }
 
 int dbmw_isPointIncluded(const struct Dbmw *dbm, const int32_t *val)
 {
-	return dbm_isPointIncluded(val, dbm->dbm, dbm->dim);
+	nbOps++;
+	switch (dbm->dim)
+	{
+		case 2:
+			return dbmSmall_isPointIncluded(val, dbm->dbm, 2);
+
+		case 3:
+			return dbmSmall_isPointIncluded(val, dbm->dbm, 3);
+
+		default:
+		{
+			cindex_t i;
+
+			for (i = 0 ; i < dbm->dim ; i++)
+			{
+				if (!dbmw_rowIncludes(&(dbm->dbm[i * dbm->dim]), val[i], val, 
+							dbm->dim))
+					return 0;
+			}
+			return 1;
+		}
+	}
+}
+
+/**
+ * Returns the index of the first DBM of dbms that includes the valuation val, 
+ * or -1 if there is none. The constraints satisfied by val are computed once, 
+ * and then compared with each DBM as a whole.
+ * @param dbms n DBMs of the same dimension
+ */
+int dbmw_firstIncluding(const struct Dbmw *const *dbms, unsigned int n, const 
+		int32_t *val)
+{
+	raw_t point[DBMWPOOL_MAXDIM * DBMWPOOL_MAXDIM];
+	cindex_t i, j, dim;
+	unsigned int k;
+
+	if (n == 0)
+		return -1;
+
+	dim = dbms[0]->dim;
+	if (dim > DBMWPOOL_MAXDIM)
+	{
+		for (k = 0 ; k < n ; k++)
+		{
+			if (dbmw_isPointIncluded(dbms[k], val))
+				return k;
+		}
+		return -1;
+	}
+
+	for (i = 0 ; i < dim ; i++)
+	{
+		for (j = 0 ; j < dim ; j++)
+			point[i * dim + j] = dbm_bound2raw(val[i] - val[j], dbm_WEAK);
+	}
+
+	for (k = 0 ; k < n ; k++)
+	{
+		nbOps++;
+		if (dbmw_coversPoint(dbms[k]->dbm, point, dim * dim))
+			return k;
+	}
+
+	return -1;
 }
 
 struct Dbmw *dbmw_reset(struct Dbmw *d, struct Clock *c)
 {
-	dbm_updateValue(d->dbm, d->dim, clock_getIndex(c), 0);
+	nbOps++;
+	switch (d->dim)
+	{
+		case 2:
+			dbmSmall_reset(d->dbm, 2, clock_getIndex(c));
+		break;
+
+		case 3:
+			dbmSmall_reset(d->dbm, 3, clock_getIndex(c));
+		break;
+
+		default:
+			dbm_updateValue(d->dbm, d->dim, clock_getIndex(c), 0);
+	}
 
 	return d;
 }
 
 struct Dbmw *dbmw_constrainClock(struct Dbmw *d, struct Clock *c, int32_t val)
 {
+	nbOps++;
 	dbm_constrainClock(d->dbm, d->dim, clock_getIndex(c), val);
 
 	return d;
@@ -148,6 +720,7 @@ struct Dbmw *dbmw_constrainClock(struct Dbmw *d, struct Clock *c, int32_t val)
 struct Dbmw *dbmw_constrain(struct Dbmw *d, struct Clock *c1, struct Clock *c2, 
 		int32_t bound, int strict)
 {
+	nbOps++;
 	dbm_constrain1(d->dbm, d->dim, (c1 == NULL) ? 0 : clock_getIndex(c1), (c2 == 
 				NULL) ? 0 : clock_getIndex(c2), dbm_boundbool2raw(bound, 
 					strict));
@@ -157,6 +730,7 @@ struct Dbmw *dbmw_constrain(struct Dbmw *d, struct Clock *c1, struct Clock *c2,
 
 struct Dbmw *dbmw_freeClock(struct Dbmw *dbm, const struct Clock *c)
 {
+	nbOps++;
 	dbm_freeClock(dbm->dbm, dbm->dim, clock_getIndex(c));
 	return dbm;
 }
@@ -165,295 +739,695 @@ struct Dbmw *dbmw_updateIncrementAll(struct Dbmw *d, unsigned int delay)
 {
 	unsigned int i;
 
-	for (i = 1 ; i < d->dim ; i++)
-		dbm_updateIncrement(d->dbm, d->dim, i, delay);
+	nbOps++;
+	for (i = 1 ; i < d->dim ; i++)
+		dbm_updateIncrement(d->dbm, d->dim, i, delay);
+
+	return d;
+}
+
+/** Assume that from is a point (i.e. valuation of the clocks, reading the first 
+ * line (or column) gives the values of the clocks), and that dst is reachable 
+ * from from (i.e. up(from)/\dst is not empty) */
+unsigned int dbmw_nextPoint(struct Dbmw *dst, const struct Dbmw *from)
+{
+	unsigned int max = 0;
+	int i;
+
+	if (from->dim == 0)
+		return 0;
+
+	for (i = 1 ; i < from->dim ; i++)
+	{
+		/* Both values are negatives, since it is 0 - x <= -bound to signal that 
+		 * x >= bound */
+		int d = dbm_raw2bound(from->dbm[i]) - dbm_raw2bound(dst->dbm[i]);
+		if (dbm_rawIsStrict(from->dbm[i]))
+			d++;
+		if (d < 0)
+		{
+			/* this should not happen if from is a point and dst intersects 
+			 * up(from) */
+			fprintf(stderr, "ERROR: computing next delay on wrong DBMs");
+			max = 0;
+			break;
+		}
+		if (d > max)
+			max = d;
+	}
+	dbmw_updateIncrementAll(dst, max);
+
+	return max;
+}
+
+/* Compute the distance of a valuation v to a zone, i.e. the smallest delay d 
+ * such that v + d is in the zone .
+ * Requires that up(v) /\ zone is not empty (thus d exists) */
+unsigned int dbmw_distance(const int32_t *val, const struct Dbmw *to)
+{
+	int i;
+
+	for (i = 1 ; i < to->dim ; i++)
+	{
+		if (val[i] > dbm_raw2bound(to->dbm[i * to->dim]))
+		{
+			fprintf(stderr, "ERROR: %d > %d\n", val[i], 
+					dbm_raw2bound(to->dbm[i] * to->dim));
+			return -1;
+		}
+	}
+
+	return (unsigned int)dbmw_maxLowerDistance(to->dbm, val, to->dim);
+}
+
+#if 0
+static struct Dbmw *dbmw_merge(const struct Dbmw *z1, const struct Dbmw *z2)
+{
+	int mergeable = 1;
+	int m, n;
+}
+#endif
+
+/**
+ * Returns the scratch storage of the calling thread, big enough for DBMs of 
+ * dimension dim. It is kept for the lifetime of the thread.
+ */
+static struct DbmwScratch *dbmwScratch_get(cindex_t dim)
+{
+	struct DbmwScratch *sc = threadScratch;
+	size_t size = (size_t)dim * dim;
+
+	if (sc == NULL)
+	{
+		sc = calloc(1, sizeof *sc);
+		if (sc == NULL)
+		{
+			perror("calloc dbmwScratch_get:sc");
+			exit(EXIT_FAILURE);
+		}
+		threadScratch = sc;
+	}
+
+	if (dim > sc->allocDim)
+	{
+		free(sc->inter);
+		free(sc->remain);
+		free(sc->minBits);
+		free(sc->pieces);
+		sc->inter = malloc(size * sizeof *(sc->inter));
+		sc->remain = malloc(size * sizeof *(sc->remain));
+		sc->minBits = malloc((size + 31) / 32 * sizeof *(sc->minBits));
+		/* At most one piece per constraint */
+		sc->pieces = malloc(size * size * sizeof *(sc->pieces));
+		if (sc->inter == NULL || sc->remain == NULL || sc->minBits == NULL || 
+				sc->pieces == NULL)
+		{
+			perror("malloc dbmwScratch_get:sc->inter");
+			exit(EXIT_FAILURE);
+		}
+		sc->allocDim = dim;
+	}
+	sc->dim = dim;
+
+	return sc;
+}
+
+/**
+ * Sets in sc->minBits a minimal set of constraints of sc->inter, a subset of 
+ * Z0, that give sc->inter back once added to Z0. Only the constraints tighter 
+ * than the ones of Z0 are candidates, and each of them is dropped if the 
+ * others that are kept imply it, so that no constraint of a zero cycle is lost. 
+ * sc->remain is used as a buffer.
+ */
+static void dbmw_minConstraintsRaw(const raw_t *Z0, struct DbmwScratch *sc)
+{
+	cindex_t k, l, dim = sc->dim, size = sc->dim * sc->dim;
+
+	memset(sc->minBits, 0, (size + 31) / 32 * sizeof *(sc->minBits));
+	for (k = 0 ; k < size ; k++)
+	{
+		if (sc->inter[k] < Z0[k])
+			sc->minBits[k / 32] |= 1U << (k % 32);
+	}
+
+	for (k = 0 ; k < size ; k++)
+	{
+		if (!(sc->minBits[k / 32] & (1U << (k % 32))))
+			continue;
+
+		dbm_copy(sc->remain, Z0, dim);
+		for (l = 0 ; l < size ; l++)
+		{
+			if (l != k && (sc->minBits[l / 32] & (1U << (l % 32))))
+				sc->remain[l] = sc->inter[l];
+		}
+		nbOps++;
+		dbm_close(sc->remain, dim);
+		if (dbm_areEqual(sc->remain, sc->inter, dim))
+			sc->minBits[k / 32] &= ~(1U << (k % 32));
+	}
+}
+
+/**
+ * Kernel of fed_subtract: writes into sc->pieces disjoint DBMs whose union is 
+ * Z0 \ Z1, and returns their number. Only the constraints of Z0 /\ Z1 that 
+ * are minimal with respect to Z0 are tried (see dbmw_minConstraintsRaw), each 
+ * at most once, and the kernel stops as soon as nothing of Z0 remains, so that 
+ * there are as few pieces as possible. Nothing is allocated.
+ */
+static unsigned int dbmw_subtractRaw(const raw_t *Z0, const raw_t *Z1, 
+		struct DbmwScratch *sc)
+{
+	cindex_t i, j, dim = sc->dim;
+	unsigned int n = 0;
+
+	nbOps++;
+	dbm_copy(sc->inter, Z0, dim);
+	if (!dbm_intersection(sc->inter, Z1, dim))
+	{
+		dbm_copy(sc->pieces, Z0, dim);
+		return 1;
+	}
+
+	dbmw_minConstraintsRaw(Z0, sc);
+	dbm_copy(sc->remain, Z0, dim);
+
+	for (i = 0 ; i < dim ; i++)
+	{
+		for (j = 0 ; j < dim ; j++)
+		{
+			cindex_t k = i * dim + j;
+			raw_t *piece;
+
+			if (i == j || !(sc->minBits[k / 32] & (1U << (k % 32))))
+				continue;
+
+			/* remain /\ not(x_i - x_j <= inter[k]) */
+			piece = &(sc->pieces[n * dim * dim]);
+			dbm_copy(piece, sc->remain, dim);
+			nbOps++;
+			if (!dbm_constrain1(piece, dim, j, i, dbm_negRaw(sc->inter[k])))
+				continue;
+			n++;
+
+			nbOps++;
+			if (!dbm_constrain1(sc->remain, dim, i, j, sc->inter[k]))
+				return n;
+		}
+	}
+
+	return n;
+}
+
+/* Fed */
+struct Fed *fed_new(cindex_t dim)
+{
+	struct Fed *f = malloc(sizeof *f);
+
+	if (f == NULL)
+	{
+		perror("malloc fed_new:f");
+		exit(EXIT_FAILURE);
+	}
+
+	f->dim = dim;
+	f->size = 0;
+	f->allocSize = FED_INITSIZE;
+	f->dbms = malloc(f->allocSize * dim * dim * sizeof *(f->dbms));
+	if (f->dbms == NULL)
+	{
+		perror("malloc fed_new:f->dbms");
+		exit(EXIT_FAILURE);
+	}
+
+	return f;
+}
+
+unsigned int fed_size(const struct Fed *f)
+{
+	return f->size;
+}
+
+void fed_clear(struct Fed *f)
+{
+	f->size = 0;
+}
+
+/* Returns the storage of a new DBM at the end of f */
+static raw_t *fed_push(struct Fed *f)
+{
+	if (f->size == f->allocSize)
+	{
+		f->allocSize *= 2;
+		f->dbms = realloc(f->dbms, f->allocSize * f->dim * f->dim * sizeof 
+				*(f->dbms));
+		if (f->dbms == NULL)
+		{
+			perror("realloc fed_push:f->dbms");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	return &(f->dbms[f->size++ * f->dim * f->dim]);
+}
+
+static void fed_appendRaw(struct Fed *f, const raw_t *dbm)
+{
+	nbOps++;
+	dbm_copy(fed_push(f), dbm, f->dim);
+}
+
+/* Removes the DBM at position i, keeping the order of the other ones */
+static void fed_removeAt(struct Fed *f, unsigned int i)
+{
+	cindex_t size = f->dim * f->dim;
+
+	memmove(&(f->dbms[i * size]), &(f->dbms[(i + 1) * size]), (f->size - i - 
+				1) * size * sizeof *(f->dbms));
+	f->size--;
+}
+
+void fed_append(struct Fed *f, const struct Dbmw *d)
+{
+	fed_appendRaw(f, d->dbm);
+}
+
+/**
+ * f becomes f U f2. The DBMs of f2 are appended, without looking for the ones 
+ * that could be merged (see fed_mergeAdjacent).
+ */
+void fed_union(struct Fed *f, const struct Fed *f2)
+{
+	unsigned int i;
+
+	for (i = 0 ; i < f2->size ; i++)
+		fed_appendRaw(f, &(f2->dbms[i * f2->dim * f2->dim]));
+}
+
+/* Returns a new Dbmw, copy of the DBM at position i */
+struct Dbmw *fed_getDbmw(const struct Fed *f, unsigned int i)
+{
+	struct Dbmw *d = dbmw_new(f->dim);
+
+	nbOps++;
+	dbm_copy(d->dbm, &(f->dbms[i * f->dim * f->dim]), f->dim);
 
 	return d;
 }
 
-/** Assume that from is a point (i.e. valuation of the clocks, reading the first 
- * line (or column) gives the values of the clocks), and that dst is reachable 
- * from from (i.e. up(from)/\dst is not empty) */
-unsigned int dbmw_nextPoint(struct Dbmw *dst, const struct Dbmw *from)
+/* f becomes f /\ d. The empty DBMs are removed */
+void fed_intersect(struct Fed *f, const struct Dbmw *d)
 {
-	unsigned int max = 0;
-	int i;
+	unsigned int i, n;
+	cindex_t size = f->dim * f->dim;
 
-	if (from->dim == 0)
-		return 0;
-
-	for (i = 1 ; i < from->dim ; i++)
+	for (i = 0, n = 0 ; i < f->size ; i++)
 	{
-		/* Both values are negatives, since it is 0 - x <= -bound to signal that 
-		 * x >= bound */
-		int d = dbm_raw2bound(from->dbm[i]) - dbm_raw2bound(dst->dbm[i]);
-		if (dbm_rawIsStrict(from->dbm[i]))
-			d++;
-		if (d < 0)
-		{
-			/* this should not happen if from is a point and dst intersects 
-			 * up(from) */
-			fprintf(stderr, "ERROR: computing next delay on wrong DBMs");
-			max = 0;
-			break;
-		}
-		if (d > max)
-			max = d;
+		raw_t *dbm = &(f->dbms[i * size]);
+
+		nbOps++;
+		if (!dbmRaw_intersection(dbm, d->dbm, f->dim))
+			continue;
+		if (n != i)
+			memcpy(&(f->dbms[n * size]), dbm, size * sizeof *dbm);
+		n++;
 	}
-	dbmw_updateIncrementAll(dst, max);
+	f->size = n;
+}
 
-	return max;
+/**
+ * f becomes f \ d. Since zones need to be convex, a DBM of f may be replaced 
+ * by several pieces, computed by dbmw_subtractRaw.
+ */
+void fed_subtract(struct Fed *f, const struct Dbmw *d)
+{
+	struct DbmwScratch *sc = dbmwScratch_get(f->dim);
+	cindex_t size = f->dim * f->dim;
+	unsigned int i, k, n = f->size;
+
+	/* The pieces of the i-th DBM are appended, and the DBM itself is removed 
+	 * when all of them are computed */
+	for (i = 0 ; i < n ; i++)
+	{
+		unsigned int nbPieces = dbmw_subtractRaw(&(f->dbms[i * size]), d->dbm, 
+				sc);
+		for (k = 0 ; k < nbPieces ; k++)
+			fed_appendRaw(f, &(sc->pieces[k * size]));
+	}
+	memmove(f->dbms, &(f->dbms[n * size]), (f->size - n) * size * sizeof 
+			*(f->dbms));
+	f->size -= n;
 }
 
-/* Compute the distance of a valuation v to a zone, i.e. the smallest delay d 
- * such that v + d is in the zone .
- * Requires that up(v) /\ zone is not empty (thus d exists) */
-unsigned int dbmw_distance(const int32_t *val, const struct Dbmw *to)
+/**
+ * Returns 1 if the union of the DBMs at positions i and j is convex, in which 
+ * case it is written in hull, and if they are included in the same DBMs of 
+ * classes (if not NULL).
+ */
+static int fed_areMergeable(const struct Fed *f, unsigned int i, unsigned int 
+		j, const struct Fed *classes, raw_t *hull)
 {
-	int i;
-	int max = 0;
+	struct DbmwScratch *sc = dbmwScratch_get(f->dim);
+	cindex_t k, size = f->dim * f->dim;
+	const raw_t *dbm1 = &(f->dbms[i * size]), *dbm2 = &(f->dbms[j * size]);
+	unsigned int n;
 
-	for (i = 1 ; i < to->dim ; i++)
+	if (classes != NULL)
 	{
-		/* take the opposite of to[i], since it is <= -c to say x >= c */
-		int d = -dbm_raw2bound(to->dbm[i]) - val[i];
-		if (dbm_rawIsStrict(to->dbm[i]))
-			d++;
-		if (val[i] > dbm_raw2bound(to->dbm[i * to->dim]))
+		for (n = 0 ; n < classes->size ; n++)
 		{
-			fprintf(stderr, "ERROR: %d > %d\n", val[i], 
-					dbm_raw2bound(to->dbm[i] * to->dim));
-			return -1;
+			const raw_t *c = &(classes->dbms[n * size]);
+			nbOps += 2;
+			if (dbm_isSubsetEq(dbm1, c, f->dim) != dbm_isSubsetEq(dbm2, c, 
+						f->dim))
+				return 0;
 		}
-		max = (d > max) ? d : max;
 	}
 
-	return (unsigned int)max;
+	/* The convex hull of two closed DBMs is closed */
+	for (k = 0 ; k < size ; k++)
+		hull[k] = (dbm1[k] > dbm2[k]) ? dbm1[k] : dbm2[k];
+
+	/* The union is the hull iff hull \ dbm1 is included in dbm2 */
+	n = dbmw_subtractRaw(hull, dbm1, sc);
+	while (n > 0)
+	{
+		n--;
+		nbOps++;
+		if (!dbm_isSubsetEq(&(sc->pieces[n * size]), dbm2, f->dim))
+			return 0;
+	}
+
+	return 1;
 }
 
-/* Reduce the number of elements that are bounded, i.e. give a DBM that 
- * represents the same zone, but may be not closed, and has a minimal number of 
- * bounds */
-static void dbmw_reduce(struct Dbmw *z)
+/**
+ * Replaces the pairs of DBMs of f whose union is convex by their union, until 
+ * there is none left. The first DBM of a pair takes the place of the union. If 
+ * classes is not NULL, only the DBMs included in the same DBMs of classes are 
+ * merged: after fed_partition, the pieces of the same class then stay 
+ * disjoint from the other classes.
+ */
+void fed_mergeAdjacent(struct Fed *f, const struct Fed *classes)
 {
-	struct Dbmw *tmp = dbmw_newcp(z);
-	struct Dbmw *res = dbmw_newcp(z);
-	int i, j, n;
+	cindex_t size = f->dim * f->dim;
+	raw_t *hull;
+	unsigned int i, j;
+	int merged;
 
-	n = z->dim;
+	if (f->size < 2)
+		return;
+	hull = malloc(size * sizeof *hull);
+	if (hull == NULL)
+	{
+		perror("malloc fed_mergeAdjacent:hull");
+		exit(EXIT_FAILURE);
+	}
 
-	for (i = 0 ; i < n ; i++)
+	/* A union may be mergeable with a DBM that was already tried */
+	do
 	{
-		for (j = 0 ; j < n ; j++)
+		merged = 0;
+		for (i = 0 ; i < f->size ; i++)
 		{
-			tmp->dbm[i * n + j] = dbm_LS_INFINITY;
-			dbm_close(tmp->dbm, n);
-			if (dbmw_areEqual(tmp, z))
-				res->dbm[i * n + j] = dbm_LS_INFINITY;
-			else
-				dbmw_copy(tmp, res);
+			for (j = i + 1 ; j < f->size ; j++)
+			{
+				if (fed_areMergeable(f, i, j, classes, hull))
+				{
+					memcpy(&(f->dbms[i * size]), hull, size * sizeof *hull);
+					fed_removeAt(f, j);
+					merged = 1;
+					j = i;
+				}
+			}
 		}
-	}		
+	} while (merged);
 
-	dbmw_copy(z, res);
+	free(hull);
+}
 
-	dbmw_free(tmp);
-	dbmw_free(res);
+void fed_free(struct Fed *f)
+{
+	free(f->dbms);
+	free(f);
 }
 
-#if 0
-static struct Dbmw *dbmw_merge(const struct Dbmw *z1, const struct Dbmw *z2)
+/**
+ * Writes the bounding box of dbm in box: box[2 * i] and box[2 * i + 1] are the 
+ * lower and upper bounds of the clock i, as stored in the DBM.
+ */
+static void dbmRaw_box(const raw_t *dbm, cindex_t dim, raw_t *box)
 {
-	int mergeable = 1;
-	int m, n;
+	cindex_t i;
+
+	for (i = 0 ; i < dim ; i++)
+	{
+		box[2 * i] = dbm[i];
+		box[2 * i + 1] = dbm[i * dim];
+	}
 }
-#endif
 
 /**
- * Compute the subtraction of two zones. Since zones need to be convex, 
- * complementing a zone may not give a zone. Thus, the result of this 
- * subtraction is a partition of the subtraction into multiple zones.
- * @param Z, Z' zones
- * @ret a list of zones whose union is Z \ Z'
+ * Returns 0 if the boxes do not intersect, in which case neither do their 
+ * zones.
  */
-struct List *dbmw_subtract(const struct Dbmw *Z0, const struct Dbmw *Z1)
+static int box_intersects(const raw_t *box1, const raw_t *box2, cindex_t dim)
 {
-	struct Dbmw *Ztmp = NULL, *Zinter = NULL, *Zremain;
-	int i, j, n;
-	struct List *ret = list_new();
+	cindex_t i;
 
-	if (Z0->dim != Z1->dim)
+	for (i = 1 ; i < dim ; i++)
 	{
-		fprintf(stderr, "ERROR: trying to subtract two DBMs of different " 
-				"dimensions.\n");
-		exit(EXIT_FAILURE);
+		if (dbm_addRawRaw(box1[2 * i + 1], box2[2 * i]) < dbm_LE_ZERO || 
+				dbm_addRawRaw(box2[2 * i + 1], box1[2 * i]) < dbm_LE_ZERO)
+			return 0;
 	}
 
-	Zinter = dbmw_newcp(Z0);
-	dbmw_intersection(Zinter, Z1);
-	dbmw_reduce(Zinter);
-	Zremain = dbmw_newcp(Z0);
+	return 1;
+}
 
-	n = Z0->dim;
-	Ztmp = dbmw_new(n);
-	
-	for (i = 0 ; i < n ; i++)
+static struct PartitionIndex *partitionIndex_new(cindex_t dim)
+{
+	struct PartitionIndex *idx = malloc(sizeof *idx);
+
+	if (idx == NULL)
 	{
-		for (j = 0 ; j < n ; j++)
-		{
-			constraint_t constraint, negConstraint;
+		perror("malloc partitionIndex_new:idx");
+		exit(EXIT_FAILURE);
+	}
 
-			if (i == j)
-				continue;
+	idx->pieces = fed_new(dim);
+	idx->nbRemoved = 0;
+	idx->allocSize = PARTITIONINDEX_INITSIZE;
+	idx->boxes = malloc(idx->allocSize * 2 * dim * sizeof *(idx->boxes));
+	idx->removed = malloc(idx->allocSize * sizeof *(idx->removed));
+	idx->tmp = malloc(dim * dim * sizeof *(idx->tmp));
+	if (idx->boxes == NULL || idx->removed == NULL || idx->tmp == NULL)
+	{
+		perror("malloc partitionIndex_new:idx->boxes");
+		exit(EXIT_FAILURE);
+	}
+
+	return idx;
+}
+
+/* Removes the holes left by partitionIndex_remove, keeping the order */
+static void partitionIndex_compact(struct PartitionIndex *idx)
+{
+	struct Fed *f = idx->pieces;
+	unsigned int i, n;
+	cindex_t boxSize = 2 * f->dim, size = f->dim * f->dim;
 
-			dbmw_init(Ztmp);
+	for (i = 0, n = 0 ; i < f->size ; i++)
+	{
+		if (idx->removed[i])
+			continue;
+		if (n != i)
+		{
+			memcpy(&(f->dbms[n * size]), &(f->dbms[i * size]), size * sizeof 
+					*(f->dbms));
+			memcpy(&(idx->boxes[n * boxSize]), &(idx->boxes[i * boxSize]), 
+					boxSize * sizeof *(idx->boxes));
+			idx->removed[n] = 0;
+		}
+		n++;
+	}
+	f->size = n;
+	idx->nbRemoved = 0;
+}
 
-			constraint = dbm_constraint2(i, j, dbm_raw2bound(Zinter->dbm[i * n + 
-						j]), dbm_rawIsStrict(Zinter->dbm[i * n + j]));
-			negConstraint = dbm_negConstraint(constraint);
+static void partitionIndex_add(struct PartitionIndex *idx, const raw_t *dbm)
+{
+	struct Fed *f = idx->pieces;
 
-			if (dbm_constrainC(Ztmp->dbm, Ztmp->dim, negConstraint) &&
-					dbmw_intersection(Ztmp, Zremain))
+	if (f->size == idx->allocSize)
+	{
+		if (2 * idx->nbRemoved >= f->size)
+			partitionIndex_compact(idx);
+		else
+		{
+			idx->allocSize *= 2;
+			idx->boxes = realloc(idx->boxes, idx->allocSize * 2 * f->dim * 
+					sizeof *(idx->boxes));
+			idx->removed = realloc(idx->removed, idx->allocSize * sizeof 
+					*(idx->removed));
+			if (idx->boxes == NULL || idx->removed == NULL)
 			{
-				list_append(ret, Ztmp);
-				Ztmp = dbmw_new(n);
-				if (dbm_constrainC(Ztmp->dbm, Ztmp->dim, constraint))
-					dbmw_intersection(Zremain, Ztmp);
+				perror("realloc partitionIndex_add:idx->boxes");
+				exit(EXIT_FAILURE);
 			}
 		}
 	}
 
-	dbmw_free(Ztmp);
-	dbmw_free(Zinter);
-	dbmw_free(Zremain);
-
-	return ret;
+	dbmRaw_box(dbm, f->dim, &(idx->boxes[f->size * 2 * f->dim]));
+	idx->removed[f->size] = 0;
+	fed_appendRaw(f, dbm);
 }
 
 /**
- * Compute Z |_| Z', i.e. {Z /\ Z'} U (Z \ Z') U (Z' \ Z)
- * Like dbmw_partition, but only for two zones. It is used in dbmw_partition.
- * @param Z, Z' two zones
- * @ret list of zones, representing the partition of Z U Z' such that for all 
- * element Zi of the partition, Zi C Z or Zi /\ Z = 0, and the same goes with 
- * Z'.
+ * Returns the position of the first piece of idx that intersects dbm, whose 
+ * bounding box is box, or -1 if there is none. Only the pieces whose box 
+ * intersects box are intersected with dbm.
  */
-struct List *dbmw_partition2(const struct Dbmw *Z0, const struct Dbmw *Z1)
+static int partitionIndex_findIntersecting(const struct PartitionIndex *idx, 
+		const raw_t *dbm, const raw_t *box)
 {
-	struct Dbmw *dbm = dbmw_newcp(Z0);
-	struct List *ret = list_new();
-	struct List *l;
-	struct ListIterator *it;
+	const struct Fed *f = idx->pieces;
+	unsigned int i;
 
-	if (dbmw_intersection(dbm, Z1))
-		list_append(ret, dbm);
-	else
+	for (i = 0 ; i < f->size ; i++)
 	{
-		dbmw_free(dbm);
-		list_append(ret, dbmw_newcp(Z0));
-		list_append(ret, dbmw_newcp(Z1));
-		return ret;
+		if (idx->removed[i] || !box_intersects(&(idx->boxes[i * 2 * f->dim]), 
+					box, f->dim))
+			continue;
+		nbOps += 2;
+		dbm_copy(idx->tmp, dbm, f->dim);
+		if (dbmRaw_intersection(idx->tmp, &(f->dbms[i * f->dim * f->dim]), 
+					f->dim))
+			return i;
 	}
 
-	l = dbmw_subtract(Z0, Z1);
-	for (it = listIterator_first(l) ; listIterator_hasNext(it) ; it = 
-			listIterator_next(it))
-	{
-		dbm = listIterator_val(it);
-		list_append(ret, dbm);
-	}
-	listIterator_release(it);
-	list_free(l, NULL);
+	return -1;
+}
 
-	l = dbmw_subtract(Z1, Z0);
-	for (it = listIterator_first(l) ; listIterator_hasNext(it) ; it = 
-			listIterator_next(it))
-	{
-		dbm = listIterator_val(it);
-		list_append(ret, dbm);
-	}
-	listIterator_release(it);
+/* Removes the piece at position i, which stays valid until the next 
+ * partitionIndex_add */
+static const raw_t *partitionIndex_remove(struct PartitionIndex *idx, unsigned 
+		int i)
+{
+	idx->removed[i] = 1;
+	idx->nbRemoved++;
+
+	return &(idx->pieces->dbms[i * idx->pieces->dim * idx->pieces->dim]);
+}
+
+/* Frees idx, and returns the Fed of its pieces, in order */
+static struct Fed *partitionIndex_free(struct PartitionIndex *idx)
+{
+	struct Fed *ret = idx->pieces;
 
-	list_free(l, NULL);
+	partitionIndex_compact(idx);
+	free(idx->boxes);
+	free(idx->removed);
+	free(idx->tmp);
+	free(idx);
 
 	return ret;
 }
 
 /**
- * Compute a partition (Z'i) of a given set of zones (Zi) such that for all i, 
- * j, Z'i C Zj or Z'i /\ Zj = 0.
- * @param list of zones (Zi)
- * @ret list of zones (Z'i)
+ * Computes a partition (Z'i) of the DBMs (Zi) of f such that for all i, j, Z'i 
+ * C Zj or Z'i /\ Zj = 0, and replaces the DBMs of f by it.
+ * The pieces computed so far are kept in a PartitionIndex, so that a new zone 
+ * is only compared with the pieces whose bounding box intersects its own. When 
+ * a zone Z intersects a piece Zi, Zi is replaced by the partition of Z U Zi, 
+ * i.e. {Z /\ Zi} U (Z \ Zi) U (Zi \ Z), which is put back in the queue of the 
+ * zones to add.
  */
-struct List *dbmw_partition(const struct List *zones)
+void fed_partition(struct Fed *f)
 {
-	struct ListIterator *it;
-	int i, changed;
-	struct Fifo *wait = fifo_empty();
-	struct List *ret = list_new();
+	struct PartitionIndex *idx;
+	struct Fed *wait;
+	struct DbmwScratch *sc;
+	cindex_t size = f->dim * f->dim;
+	raw_t *Z, *box;
+	unsigned int head, k, n;
+
+	if (f->size == 0)
+		return;
 
-	for (it = listIterator_first(zones), i = 0 ; listIterator_hasNext(it) ; it = 
-			listIterator_next(it), i++)
+	idx = partitionIndex_new(f->dim);
+	wait = fed_new(f->dim);
+	Z = malloc(size * sizeof *Z);
+	box = malloc(2 * f->dim * sizeof *box);
+	if (Z == NULL || box == NULL)
 	{
-		struct Dbmw *dbm = listIterator_val(it);
-		if (i == 0)
-			list_append(ret, dbmw_newcp(dbm));
-		else
-			fifo_enqueue(wait, dbmw_newcp(dbm));
+		perror("malloc fed_partition:Z");
+		exit(EXIT_FAILURE);
 	}
-	listIterator_release(it);
-
-	while (!fifo_isEmpty(wait))
-	{
-		struct Dbmw *Z = fifo_dequeue(wait);
-		struct Dbmw *Zi;
 
-		//fprintf(stderr, "Z = %s\n", dbmw_sprint(Z, clocks));
+	partitionIndex_add(idx, f->dbms);
+	for (k = 1 ; k < f->size ; k++)
+		fed_appendRaw(wait, &(f->dbms[k * size]));
 
-		changed = 0;
+	head = 0;
+	while (head < wait->size)
+	{
+		const raw_t *Zi;
+		int pos;
 
-		for (it = listIterator_first(ret) ; !changed && listIterator_hasNext(it) 
-				; it = listIterator_next(it))
+		/* Z is copied, since the queue may be reallocated below */
+		memcpy(Z, &(wait->dbms[head * size]), size * sizeof *Z);
+		head++;
+		if (2 * head >= wait->allocSize)
 		{
-			Zi = listIterator_val(it);
-			if (dbmw_intersects(Z, Zi))
-				changed = 1;
+			memmove(wait->dbms, &(wait->dbms[head * size]), (wait->size - head) 
+					* size * sizeof *(wait->dbms));
+			wait->size -= head;
+			head = 0;
 		}
-		listIterator_release(it);
 
-		if (changed && dbmw_areEqual(Z, Zi))
-			dbmw_free(Z);
-		/* If !changed, then there cannot exist Zi in ret such that Z = Zi since 
-		 * for all Zi in ret, Zi /\ Z = 0
-		 * else if (!changed && list_search(ret, Z, (int (*)(const void *, const 
-							void *))dbmw_areEqual) == NULL) */
-		else if (!changed)
-			list_append(ret, Z);
-		else
-		{
-			struct List *ZUZi = dbmw_partition2(Z, Zi);
-			for (it = listIterator_first(ZUZi) ; listIterator_hasNext(it) ; it = 
-					listIterator_next(it))
-			{
-				struct Dbmw *dbm = listIterator_val(it);
-				fifo_enqueue(wait, dbm);
-			}
-			listIterator_release(it);
-			list_free(ZUZi, NULL);
-			
-			list_remove(ret, Zi);
+		dbmRaw_box(Z, f->dim, box);
+		pos = partitionIndex_findIntersecting(idx, Z, box);
 
-			dbmw_free(Zi);
-			dbmw_free(Z);
+		/* If pos < 0, then there cannot exist Zi in the partition such that Z = 
+		 * Zi since for all Zi, Zi /\ Z = 0 */
+		if (pos < 0)
+		{
+			partitionIndex_add(idx, Z);
+			continue;
 		}
+
+		Zi = &(idx->pieces->dbms[pos * size]);
+		nbOps++;
+		if (dbm_areEqual(Z, Zi, f->dim))
+			continue;
+
+		Zi = partitionIndex_remove(idx, pos);
+		fed_appendRaw(wait, Z);
+		nbOps++;
+		dbmRaw_intersection(&(wait->dbms[(wait->size - 1) * size]), Zi, 
+				f->dim);
+		sc = dbmwScratch_get(f->dim);
+		n = dbmw_subtractRaw(Z, Zi, sc);
+		for (k = 0 ; k < n ; k++)
+			fed_appendRaw(wait, &(sc->pieces[k * size]));
+		n = dbmw_subtractRaw(Zi, Z, sc);
+		for (k = 0 ; k < n ; k++)
+			fed_appendRaw(wait, &(sc->pieces[k * size]));
 	}
 
-	fifo_free(wait);
+	fed_free(wait);
+	free(Z);
+	free(box);
 
-	return ret;
+	wait = partitionIndex_free(idx);
+	free(f->dbms);
+	f->dbms = wait->dbms;
+	f->size = wait->size;
+	f->allocSize = wait->allocSize;
+	free(wait);
 }
 
-
 /**
  * Compute Z |^| Z', i.e. the set of x in Z such that there exists d in R such 
  * that x + d is in Z' and for all d' <= d, x + d' in Z U Z'.
@@ -466,42 +1440,74 @@ struct List *dbmw_partition(const struct List *zones)
  */
 struct Dbmw *dbmw_upTo(const struct Dbmw *Z0, const struct Dbmw *Z1)
 {
-	struct Dbmw *z0 = dbmw_newcp(Z0), *z1 = dbmw_newcp(Z1);
-	struct Dbmw *ret = NULL;
-	struct ListIterator *it;
+	struct Dbmw *ret = dbmw_new(Z0->dim);
+
+	if (!dbmw_upToInto(ret, Z0, Z1))
+	{
+		dbmw_free(ret);
+		return NULL;
+	}
+
+	return ret;
+}
+
+/**
+ * Same as dbmw_upTo, but the result is written in dst. 
+ * @ret 1 if the result is not empty, 0 otherwise, in which case dst is left 
+ * undefined
+ */
+int dbmw_upToInto(struct Dbmw *dst, const struct Dbmw *Z0, const struct Dbmw 
+		*Z1)
+{
+	raw_t buf0[DBMW_SMALLDIM * DBMW_SMALLDIM], buf1[DBMW_SMALLDIM * 
+		DBMW_SMALLDIM];
+	struct Dbmw small0 = {buf0, Z0->dim, NULL}, small1 = {buf1, Z0->dim, 
+		NULL};
+	struct Dbmw *z0, *z1;
+	int ret = 0;
+
+	/* The temporary zones are on the stack for the small dimensions */
+	if (Z0->dim <= DBMW_SMALLDIM)
+	{
+		z0 = dbmw_copy(&small0, Z0);
+		z1 = dbmw_copy(&small1, Z1);
+	}
+	else
+	{
+		z0 = dbmw_newcp(Z0);
+		z1 = dbmw_newcp(Z1);
+	}
 
 	dbmw_up(z0);
 	dbmw_down(z1);
 
 	if (dbmw_intersection(z0, z1))
 	{
-		struct List *l = dbmw_subtract(z0, Z1);
+		struct DbmwScratch *sc = dbmwScratch_get(Z0->dim);
+		unsigned int i, n = dbmw_subtractRaw(z0->dbm, Z1->dbm, sc);
 		int ok = 1;
-		for (it = listIterator_first(l) ; listIterator_hasNext(it) ; it = 
-				listIterator_next(it))
+
+		for (i = 0 ; ok && i < n ; i++)
 		{
-			struct Dbmw *z = listIterator_val(it);
+			struct Dbmw piece = {&(sc->pieces[i * Z0->dim * Z0->dim]), 
+				Z0->dim, NULL};
 
-			if (!dbmw_isSubsetEq(z, Z0))
+			if (!dbmw_isSubsetEq(&piece, Z0))
 				ok = 0;
 		}
-		listIterator_release(it);
 
 		if (ok)
 		{
-			ret = dbmw_newcp(Z0);
-			if (!dbmw_intersection(ret, z1))
-			{
-				dbmw_free(ret);
-				ret = NULL;
-			}
+			dbmw_copy(dst, Z0);
+			ret = dbmw_intersection(dst, z1);
 		}
-
-		list_free(l, (void (*)(void *))dbmw_free);
 	}
 
-	dbmw_free(z0);
-	dbmw_free(z1);
+	if (Z0->dim > DBMW_SMALLDIM)
+	{
+		dbmw_free(z0);
+		dbmw_free(z1);
+	}
 	
 	return ret;
 }
@@ -774,9 +1780,231 @@ struct Dbmw *dbmw_load(FILE *f)
 	return ret;
 }
 
+/**
+ * d goes back to the pool of the calling thread, which may not be the thread 
+ * that allocated it.
+ */
 void dbmw_free(struct Dbmw *d)
 {
-	free(d->dbm);
-	free(d);
+	if (d->dim <= DBMWPOOL_MAXDIM && dbmwPool.nbFree[d->dim] < 
+			DBMWPOOL_MAXFREE)
+	{
+		d->next = dbmwPool.free[d->dim];
+		dbmwPool.free[d->dim] = d;
+		dbmwPool.nbFree[d->dim]++;
+	}
+	else
+		free(d);
+}
+
+struct DbmwTable *dbmwTable_new(void)
+{
+	struct DbmwTable *t = malloc(sizeof *t);
+	unsigned int i;
+
+	if (t == NULL)
+	{
+		perror("malloc dbmwTable_new:t");
+		exit(EXIT_FAILURE);
+	}
+
+	for (i = 0 ; i < DBMWTABLE_NBSTRIPES ; i++)
+	{
+		struct DbmwTableStripe *st = &(t->stripes[i]);
+
+		st->nbBuckets = DBMWTABLE_INITSIZE;
+		st->size = 0;
+		st->buckets = calloc(st->nbBuckets, sizeof *(st->buckets));
+		if (st->buckets == NULL)
+		{
+			perror("calloc dbmwTable_new:st->buckets");
+			exit(EXIT_FAILURE);
+		}
+		pthread_mutex_init(&(st->mutex), NULL);
+	}
+
+	return t;
+}
+
+static struct DbmwTableStripe *dbmwTable_stripe(struct DbmwTable *t, uint32_t 
+		hash)
+{
+	return &(t->stripes[hash % DBMWTABLE_NBSTRIPES]);
+}
+
+static struct Dbmw **dbmwTableStripe_bucket(struct DbmwTableStripe *st, 
+		uint32_t hash)
+{
+	return &(st->buckets[(hash / DBMWTABLE_NBSTRIPES) % st->nbBuckets]);
+}
+
+/* The lock of st must be held */
+static void dbmwTableStripe_grow(struct DbmwTableStripe *st)
+{
+	struct Dbmw **buckets;
+	unsigned int i, nbBuckets = st->nbBuckets;
+
+	buckets = st->buckets;
+	st->nbBuckets = 2 * nbBuckets;
+	st->buckets = calloc(st->nbBuckets, sizeof *(st->buckets));
+	if (st->buckets == NULL)
+	{
+		perror("calloc dbmwTableStripe_grow:st->buckets");
+		exit(EXIT_FAILURE);
+	}
+
+	for (i = 0 ; i < nbBuckets ; i++)
+	{
+		struct Dbmw *d, *next;
+
+		for (d = buckets[i] ; d != NULL ; d = next)
+		{
+			struct Dbmw **pb = dbmwTableStripe_bucket(st, d->hash);
+
+			next = d->next;
+			d->next = *pb;
+			*pb = d;
+		}
+	}
+
+	free(buckets);
+}
+
+/**
+ * Returns the DBM of t equal to d, with one more reference, and frees d. If 
+ * there is none, d itself is added to t. d must be closed, and the returned 
+ * DBM must not be modified, since it is shared: two DBMs interned in the same 
+ * table are equal iff they are the same pointer.
+ */
+const struct Dbmw *dbmwTable_intern(struct DbmwTable *t, struct Dbmw *d)
+{
+	struct Dbmw *e, **pb;
+	uint32_t hash = dbmw_hash(d);
+	struct DbmwTableStripe *st = dbmwTable_stripe(t, hash);
+
+	pthread_mutex_lock(&(st->mutex));
+	for (e = *dbmwTableStripe_bucket(st, hash) ; e != NULL ; e = e->next)
+	{
+		if (e->hash == hash && dbmw_areEqual(e, d))
+		{
+			e->refCount++;
+			pthread_mutex_unlock(&(st->mutex));
+			dbmw_free(d);
+			return e;
+		}
+	}
+
+	if (st->size >= st->nbBuckets)
+		dbmwTableStripe_grow(st);
+	d->hash = hash;
+	d->isInterned = 1;
+	d->refCount = 1;
+	pb = dbmwTableStripe_bucket(st, hash);
+	d->next = *pb;
+	*pb = d;
+	st->size++;
+	pthread_mutex_unlock(&(st->mutex));
+
+	return d;
+}
+
+/* Adds a reference to d, interned in t */
+const struct Dbmw *dbmwTable_ref(struct DbmwTable *t, const struct Dbmw *d)
+{
+	struct DbmwTableStripe *st = dbmwTable_stripe(t, d->hash);
+
+	pthread_mutex_lock(&(st->mutex));
+	((struct Dbmw *)d)->refCount++;
+	pthread_mutex_unlock(&(st->mutex));
+
+	return d;
+}
+
+/* Removes a reference to d, interned in t, and frees it if it was the last */
+void dbmwTable_release(struct DbmwTable *t, const struct Dbmw *d)
+{
+	struct DbmwTableStripe *st = dbmwTable_stripe(t, d->hash);
+	struct Dbmw **pe;
+
+	pthread_mutex_lock(&(st->mutex));
+	if (--((struct Dbmw *)d)->refCount > 0)
+	{
+		pthread_mutex_unlock(&(st->mutex));
+		return;
+	}
+
+	for (pe = dbmwTableStripe_bucket(st, d->hash) ; *pe != d ; pe = 
+			&((*pe)->next))
+		;
+	*pe = d->next;
+	st->size--;
+	pthread_mutex_unlock(&(st->mutex));
+
+	dbmw_free((struct Dbmw *)d);
+}
+
+/* Must not be called while other threads use t */
+unsigned int dbmwTable_size(const struct DbmwTable *t)
+{
+	unsigned int i, size = 0;
+
+	for (i = 0 ; i < DBMWTABLE_NBSTRIPES ; i++)
+		size += t->stripes[i].size;
+
+	return size;
+}
+
+/* All the DBMs of t must have been released */
+void dbmwTable_free(struct DbmwTable *t)
+{
+	unsigned int i;
+
+	for (i = 0 ; i < DBMWTABLE_NBSTRIPES ; i++)
+	{
+		pthread_mutex_destroy(&(t->stripes[i].mutex));
+		free(t->stripes[i].buckets);
+	}
+	free(t);
+}
+
+/**
+ * Frees the Dbmws kept in the pool of the calling thread, as well as its 
+ * scratch storage. Once the zone graph is built, it is called on every thread 
+ * of the build pool, the only threads that work on DBMs during the 
+ * construction.
+ */
+void dbmw_releasePool(void)
+{
+	cindex_t dim;
+
+	for (dim = 0 ; dim <= DBMWPOOL_MAXDIM ; dim++)
+	{
+		while (dbmwPool.free[dim] != NULL)
+		{
+			struct Dbmw *d = dbmwPool.free[dim];
+			dbmwPool.free[dim] = d->next;
+			free(d);
+		}
+		dbmwPool.nbFree[dim] = 0;
+	}
+
+	if (threadScratch != NULL)
+	{
+		free(threadScratch->inter);
+		free(threadScratch->remain);
+		free(threadScratch->minBits);
+		free(threadScratch->pieces);
+		free(threadScratch);
+		threadScratch = NULL;
+	}
+}
+
+/**
+ * Returns the number of udbm operations performed so far by the calling 
+ * thread.
+ */
+unsigned long dbmw_nbOps(void)
+{
+	return nbOps;
 }
 
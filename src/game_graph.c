@@ -1,25 +1,38 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include "game_graph.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 #include <stdint.h>
+#include <time.h>
+#ifdef HAVE_MALLOC_H
+#include <malloc.h>
+#endif
 
 #include <list.h>
-#include <set.h>
 #include <fifo.h>
-#include <tree.h>
 
 #include "parser.h"
 #include "dbmutils.h"
 #include "serialize.h"
+#include "threadpool.h"
 
 #define EVENTSEP		""
 #define EVENTSEPSIZE	0	/* strlen(EVENTSEP) */
-#define NBSUCCS			256
 #define CANARY			0xdeadbeefdeadbeefUL
 #define NBLEAVESTYPES	3
+#define ZONESET_INITSIZE	64
+#define ZONEHEAP_INITSIZE	64
+#define REFINE_BATCHPERTHREAD	2
+#define STRINGDAG_INITSIZE	64
+#define WORDARENA_BLOCKSIZE	65536
+#define ATTR_PARALLELMIN	4096	/* Smaller frontiers are not split */
 
 #ifndef ENFORCER_VERDICT_WIN
 	#define ENFORCER_VERDICT_WIN "WIN"
@@ -48,11 +61,24 @@ struct State
 	char *name;
 	int isInitial;
 	int isAccepting;
-	/* StateEdge[] */
-	struct List *contSuccs[NBSUCCS];
-	/* StateEdge[] */
-	struct List *uncontSuccs[NBSUCCS];
+	/* StateEdge *[], grouped by event: the edges labelled by the controllable 
+	 * event of index i are contSuccs[contSuccsStart[i]] to 
+	 * contSuccs[contSuccsStart[i + 1] - 1] */
+	struct StateEdge **contSuccs;
+	unsigned int *contSuccsStart;
+	/* Same for the uncontrollable events */
+	struct StateEdge **uncontSuccs;
+	unsigned int *uncontSuccsStart;
 	unsigned int index;
+	/* StateEdge *[], in the order of contSuccs then uncontSuccs for each 
+	 * event */
+	const struct StateEdge **outEdges;
+	unsigned int nbOutEdges;
+	/* Distinct states reachable (resp. co-reachable) through one edge */
+	const struct State **succStates;
+	unsigned int nbSuccStates;
+	const struct State **predStates;
+	unsigned int nbPredStates;
 };
 
 struct StateEdge
@@ -70,6 +96,8 @@ struct TimedAutomaton
 	unsigned int nbStates;
 	struct Clock **clocks;
 	unsigned int nbClocks;
+	unsigned int nbConts;
+	unsigned int nbUnconts;
 	/* SymbolTableEl[] */
 	const struct List *contsTable;
 	/* SymbolTableEl[] */
@@ -83,7 +111,8 @@ struct TimedAutomaton
 struct Zone
 {
 	const struct State *s;
-	struct Dbmw *dbm;
+	/* Interned in zg->dbms */
+	const struct Dbmw *dbm;
 	struct Zone **contSuccs;
 	/* Clock *[] */
 	struct List **resetsConts;
@@ -91,6 +120,10 @@ struct Zone
 	/* Clock *[] */
 	struct List **resetsUnconts;
 	struct Zone *timeSucc;
+	/* DBMs of the zone, of its time successor, of the time successor of its 
+	 * time successor, etc. */
+	const struct Dbmw **timeChain;
+	unsigned int timeChainLength;
 	/* ZoneEdge[] */
 	struct List *edges;
 	unsigned int index;
@@ -110,21 +143,157 @@ struct ZoneGraph
 	struct Zone *z0;
 	struct Zone *sinkZone;
 	unsigned int nbZones;
+	/* The DBMs of the zones, shared by the equal zones */
+	struct DbmwTable *dbms;
+};
+
+struct ZoneSetEntry
+{
+	struct Zone *z;
+	uint32_t hash;
+	unsigned long seq;
+	/* Position in a ZoneHeap, -1 if not in a heap */
+	int heapIndex;
+	/* Next entry in the same bucket */
+	struct ZoneSetEntry *nextBucket;
+	/* Insertion order */
+	struct ZoneSetEntry *prev;
+	struct ZoneSetEntry *next;
+	/* Insertion order among the zones of the same state */
+	struct ZoneSetEntry *prevS;
+	struct ZoneSetEntry *nextS;
 };
 
-struct ArrayTwo
+/* Set of zones, indexed by (state, DBM), that keeps the insertion order */
+struct ZoneSet
 {
+	struct ZoneSetEntry **buckets;
+	unsigned int nbBuckets;
+	unsigned int size;
+	unsigned long nextSeq;
+	struct ZoneSetEntry *first;
+	struct ZoneSetEntry *last;
+	/* Entries of each state, indexed by State.index */
+	struct ZoneSetEntry **firstS;
+	struct ZoneSetEntry **lastS;
+	unsigned int nbStates;
+};
+
+/* Binary min-heap of ZoneSetEntries ordered by insertion sequence number */
+struct ZoneHeap
+{
+	struct ZoneSetEntry **entries;
+	unsigned int size;
 	unsigned int allocSize;
+};
+
+/* State of the partition refinement of zoneGraph_new */
+struct Refinement
+{
+	struct ZoneSet *rho;
+	struct ZoneSet *alpha;
+	struct ZoneSet *sigma;
+	/* Zones of alpha that are not in sigma, i.e. not known to be stable. sigma 
+	 * is always included in alpha, so that a zone that is added to alpha is 
+	 * unstable, and a zone that is removed from sigma becomes unstable again. 
+	 * The next zone to split is the oldest unstable zone of alpha. */
+	struct ZoneHeap *unstable;
+	/* dirty[i] is set when the zones of the state of index i change in rho */
+	int *dirty;
+	unsigned int nbStates;
+	/* Statistics */
+	unsigned long nbIterations;
+	unsigned long nbSplits;
+	unsigned int peakZones;
+};
+
+/* Argument of zoneGraph_splitZonesSlice */
+struct SplitZonesArg
+{
+	struct Refinement *r;
+	struct Zone **batch;
+	/* splits[i] = zoneGraph_splitZones(batch[i], r->rho) */
+	struct List **splits;
+};
+
+/* Argument of zoneGraph_computeSuccsSlice */
+struct ComputeSuccsArg
+{
+	const struct ZoneGraph *zg;
+	struct Zone **zones;
+	/* One flag per worker */
+	int *sinkZoneReached;
+};
+
+/* size x size matrix of bits, stored row by row, each row padded to a whole 
+ * number of words */
+struct BitMatrix
+{
 	unsigned int size;
-	int **tab;
+	unsigned int rowWords;
+	uint64_t *bits;
+};
+
+/* Set of nodes, one bit per node index. The padding bits are never set */
+struct NodeSet
+{
+	unsigned int nbNodes;
+	unsigned int nbWords;
+	uint64_t *bits;
 };
 
+/* State of a buffer word w: lasts[i] is the zone reached from the i-th zone 
+ * by reading w, and array links i to each zone met on the way */
 struct StringArray
 {
-	char *s;
-	struct ArrayTwo *array;
+	struct BitMatrix *array;
 	unsigned int size;
 	const struct Zone **lasts;
+	uint32_t hash;
+	/* Index in the StringDag, and next state of the same bucket */
+	unsigned int index;
+	struct StringArray *nextBucket;
+	/* 1 if the state is extended, i.e. its successors are computed */
+	int isExtended;
+};
+
+/**
+ * Distinct states of the buffer words, each computed once. The words that 
+ * reach the same state have the same subtree in the game graph, so only the 
+ * successors of the states are stored: succs[i * nbConts + c] is the state 
+ * reached from states[i] by the c-th controllable event, and expand[i * 
+ * nbConts + c] is 0 if it has the same array as states[i], in which case the 
+ * word is not extended any further.
+ */
+struct StringDag
+{
+	unsigned int nbConts;
+	struct StringArray **states;
+	unsigned int nbStates;
+	unsigned int allocStates;
+	unsigned int *succs;
+	unsigned char *expand;
+	/* Number of words of the subtree of each extended state, 0 if not computed 
+	 * yet (see stringDag_nbWords) */
+	unsigned long *nbWords;
+	/* Indexes of the states, by hash */
+	struct StringArray **buckets;
+	unsigned int nbBuckets;
+};
+
+/* Words and real words of the nodes, copied one after the other in blocks 
+ * that are only freed with the graph */
+struct WordArenaBlock
+{
+	struct WordArenaBlock *next;
+	size_t size;
+	size_t used;
+	char data[];
+};
+
+struct WordArena
+{
+	struct WordArenaBlock *first;
 };
 
 typedef struct Node
@@ -140,16 +309,13 @@ typedef struct Node
 		{
 			struct Node *succEmit;
 			struct Node *succStopEmit;
-			/* Node *[] */
-			struct List *predsEmit;
-			/* Node *[] */
-			struct List *predsUncont;
 			struct Node *predContRcvd;
 			struct Node *predTime;
 			enum Strat strat;
 		} p0;
 		struct
 		{
+			/* Slices of Graph.succTable */
 			struct Node **succsCont;
 			struct Node **succsUncont;
 			struct Node *predStop;
@@ -161,11 +327,63 @@ typedef struct Node
 	int isWinning;
 	int isLeaf;
 	unsigned int index;
-	/* Edge *[] */
-	struct List *edges;
 	void *userData;
 } Node;
 
+/**
+ * Storage for the solver, which follows the edges of the graph (see struct 
+ * Graph). The subgames being solved at the same time have disjoint nodes, so 
+ * they share the node sets, whose bits are only updated atomically.
+ */
+struct Attractor
+{
+	/* Number of successors not in the attractor yet */
+	unsigned int *nbSuccsLeft;
+	/* Storage for the frontiers of the subgames */
+	struct Node **frontier;
+	struct Node **next;
+	/* Nodes solved and winning for player 0 */
+	struct NodeSet *won;
+	/* Nodes of the subgames being solved */
+	struct NodeSet *inSub;
+	struct NodeSet *accepting;
+	struct NodeSet *R;
+	struct NodeSet *Tr;
+	struct NodeSet *W;
+};
+
+/* Nodes of a strongly connected component still to be solved */
+struct SubGame
+{
+	struct Node **nodes;
+	unsigned int nbNodes;
+	/* Nodes added to the attractor at the last step, and being added */
+	struct Node **frontier;
+	struct Node **next;
+	unsigned int nbNext;
+};
+
+/* Argument of graph_attrInitSlice and graph_attrFrontierSlice */
+struct AttrArg
+{
+	const struct Graph *g;
+	struct Attractor *attr;
+	struct SubGame *sub;
+	struct NodeSet *ret;
+	const struct NodeSet *U;
+	int player;
+};
+
+/* Argument of graph_solveSccsSlice */
+struct SolveSccsArg
+{
+	const struct Graph *g;
+	struct Attractor *attr;
+	struct SubGame *subs;
+	/* Components of the level being solved */
+	const unsigned int *sccs;
+};
+
 struct SearchNode
 {
 	const struct Zone *z;
@@ -190,10 +408,38 @@ struct Graph
 	/* Node *[][2] */
 	struct List *nodesP[2];
 	struct Node **baseNodes;
+	/* The node of index i is nodeArray[i]. Each node of player 1 has a slice 
+	 * of nbConts + nbUnconts successors in succTable. */
+	struct Node *nodeArray;
+	unsigned int allocNodes;
+	struct Node **succTable;
+	unsigned int nbSuccSlices;
+	unsigned int allocSuccSlices;
+	/* Edges of the nodes, built by graph_buildEdges once all the successors 
+	 * are set: the edges of the node of index i are the k from edgesStart[i] 
+	 * to edgesStart[i + 1] - 1, to the node of index edgeSuccs[k], of type 
+	 * edgeTypes[k] (an enum EdgeType). Likewise, preds[predsStart[i]] to 
+	 * preds[predsStart[i + 1] - 1] are the indices of the predecessors of the 
+	 * node of index i, one per edge. */
+	unsigned int *edgesStart;
+	unsigned int *edgeSuccs;
+	unsigned char *edgeTypes;
+	unsigned int *predsStart;
+	unsigned int *preds;
+	struct WordArena *words;
 	unsigned int nbNodes;
 	unsigned int nbConts;
 	unsigned int nbUnconts;
 	unsigned int nbZones;
+	struct GraphStats stats;
+};
+
+/* Start of a phase of the construction of a graph */
+struct PhaseTimer
+{
+	struct timespec wall;
+	struct timespec cpu;
+	unsigned long nbDbmOps;
 };
 
 struct StratNode
@@ -242,25 +488,15 @@ struct PrivateEvent
 
 struct Clock **clocks;
 
-/* Shortcuts functions for ccontainers */
-static int listIn(struct List *l, void *data);
-static void listAddNoDouble(struct List *l, void *data);
-static void removeSetFromList(struct List *l, const struct Set *s);
-
 /* Comparison functions used with list_search */
 #if 0
 static int cmpSymbolChar(const void *val, const void *pel);
 #endif
 static int cmpSymbolLabel(const void *val, const void *pel);
 static int cmpSymId(const void *val, const void *pel);
-static int cmpEdge(const void *pe1, const void *pe2);
 static int cmpZoneIndex(const void *val, const void *pz);
-static int cmpNodeIndex(const void *val, const void *pn);
-static int eqPtr(const void *p1, const void *p2);
 
-/* To be used with set_applyToAll */
-static void node_setWinning(void *dummy, void *pn);
-static void node_computeStrat(void *dummy,void *pn);
+static void node_computeStrat(struct Node *n);
 
 /*SymbolTableEl */
 static struct SymbolTableEl *symbolTableEl_new(char, const char *, unsigned 
@@ -270,43 +506,59 @@ static struct SymbolTableEl *symbolTableEl_load(FILE *, const struct Graph *);
 static void symbolTableEl_free(struct SymbolTableEl *el);
 
 /* Node */
-static struct Node *node_new(const struct Graph *, const struct Zone *, const 
-		char *word, int owner);
-static char *node_computeRealWord(const struct Node *);
+static struct Node *node_new(struct Graph *, const struct Zone *, const char 
+		*word, int owner, unsigned int index);
+static char *node_computeRealWord(struct Graph *, const char *word);
 static struct Node *node_succCont(const struct Graph *, const struct Node *prev, 
 		char cont);
-static void node_addEdgeNoDouble(struct Node *n, enum EdgeType type, struct Node 
-		*succ);
 static void node_addEdgeStop(struct Node *n, struct Node *succ);
 static void node_addEdgeCont(struct Node *n, struct Node *succ, int);
 static void node_addEdgeUncont(struct Node *n, struct Node *succ, int);
 static void node_addEdgeEmit(struct Node *n, struct Node *succ);
 static void node_addEdgeTime(struct Node *n, struct Node *succ);
+static unsigned int node_listEdges(const struct Node *, unsigned int *succs, 
+		unsigned char *types);
 static void node_save(const struct Node *, FILE *);
-static struct List *node_loadAll(FILE *, const struct Graph *g);
-static void node_free(Node *n);
+static struct List *node_loadAll(FILE *, struct Graph *g);
+static struct Node *node_loadSucc(const struct Graph *, unsigned int index, 
+		const char *name, const struct Node *n);
 
-/* Edge */
-static struct Edge *edge_new(enum EdgeType type, struct Node *n);
-static void edge_free(struct Edge *e);
+/* WordArena */
+static struct WordArena *wordArena_new(void);
+static char *wordArena_alloc(struct WordArena *, size_t);
+static char *wordArena_strdup(struct WordArena *, const char *);
+static void wordArena_free(struct WordArena *);
 
 /* State */
-static void state_save(const struct State *, FILE *);
+static void state_init(struct State *, const struct TimedAutomaton *);
+static void state_addEdge(struct State *, const struct TimedAutomaton *, enum 
+		ContType, unsigned int, struct StateEdge *);
+static void state_save(const struct State *, const struct TimedAutomaton *, 
+		FILE *);
 static void state_loadAll(FILE *, struct TimedAutomaton *a);
-static void state_free(struct State *s);
+static void state_computeAdjacency(struct State *s, const struct 
+		TimedAutomaton *a);
+static int state_haveSameEdges(const struct State *, const struct State *, 
+		const struct TimedAutomaton *);
+static int state_cmpName(const void *, const void *);
+static void state_free(struct State *s, const struct TimedAutomaton *a);
 
 /* StateEdge */
 static struct StateEdge *stateEdge_new(const struct TimedAutomaton *, const 
 		struct State *, const struct List *guards, const struct List *resets);
 static void stateEdge_save(const struct StateEdge *, FILE *);
 static struct StateEdge *stateEdge_load(FILE *, const struct TimedAutomaton *);
+static int stateEdge_areEqual(const struct StateEdge *, const struct StateEdge 
+		*);
 static void stateEdge_free(struct StateEdge *);
 
 /* Zone */
+static struct Zone *zone_alloc(const struct State *, const struct ZoneGraph *);
 static struct Zone *zone_new(const struct State *, struct Dbmw *, const struct 
 		ZoneGraph *);
 static struct Zone *zone_newcp(const struct Zone *);
 static int zone_areEqual(const struct Zone *, const struct Zone *);
+static uint32_t zone_hash(const struct Zone *);
 static struct Zone *zone_nextCont(const struct Zone *, char);
 static void zone_addEdge(struct Zone *, const struct Zone *, enum EdgeType );
 static void zone_save(const struct Zone *, FILE *);
@@ -314,6 +566,29 @@ static struct List *zone_loadAll(FILE *, const struct ZoneGraph *, const struct
 		Graph *);
 static void zone_free(struct Zone *);
 
+/* ZoneSet */
+static struct ZoneSet *zoneSet_new(unsigned int nbStates);
+static void zoneSet_grow(struct ZoneSet *);
+static struct ZoneSetEntry *zoneSet_find(const struct ZoneSet *, const struct 
+		Zone *);
+static struct Zone *zoneSet_search(const struct ZoneSet *, const struct Zone *);
+static struct ZoneSetEntry *zoneSet_add(struct ZoneSet *, struct Zone *);
+static struct Zone *zoneSet_remove(struct ZoneSet *, const struct Zone *);
+static struct Zone **zoneSet_neighbours(const struct ZoneSet *, const struct 
+		State *, const struct State **, unsigned int, unsigned int *);
+static void zoneSet_free(struct ZoneSet *, void (*)(struct Zone *));
+static int zoneSetEntry_cmpSeq(const void *, const void *);
+
+/* ZoneHeap */
+static struct ZoneHeap *zoneHeap_new(void);
+static void zoneHeap_swap(struct ZoneHeap *, unsigned int, unsigned int);
+static void zoneHeap_siftUp(struct ZoneHeap *, unsigned int);
+static void zoneHeap_siftDown(struct ZoneHeap *, unsigned int);
+static void zoneHeap_push(struct ZoneHeap *, struct ZoneSetEntry *);
+static void zoneHeap_remove(struct ZoneHeap *, struct ZoneSetEntry *);
+static struct Zone *zoneHeap_top(const struct ZoneHeap *);
+static void zoneHeap_free(struct ZoneHeap *);
+
 /* ZoneEdge */
 static struct ZoneEdge *zoneEdge_new(enum EdgeType, const struct Zone *);
 static int zoneEdge_cmp(const struct ZoneEdge *, const struct ZoneEdge *);
@@ -324,51 +599,147 @@ static struct TimedAutomaton *timedAutomaton_new(const struct List *contsTable,
 		const struct SymbolTableEl *contsEls[], const struct List *uncontsTable, 
 		const struct SymbolTableEl *uncontsEls[], const struct List *states, 
 		const struct List *clocks, const struct List *edges);
+static void timedAutomaton_computeAdjacency(struct TimedAutomaton *);
+static const struct State **timedAutomaton_diff(const struct TimedAutomaton *, 
+		const struct TimedAutomaton *, int *);
 static void timedAutomaton_save(const struct TimedAutomaton *, FILE *);
 static struct TimedAutomaton *timedAutomaton_load(FILE *, const struct Graph *);
 static void timedAutomaton_free(struct TimedAutomaton *);
 
-/* ArrayTwo */
-static struct ArrayTwo *arraytwo_new(unsigned int size, int defaultVal);
-static struct ArrayTwo *arraytwo_newcp(const struct ArrayTwo *);
-static void arraytwo_cp(struct ArrayTwo *, const struct ArrayTwo *);
-static int arraytwo_cmp(const struct ArrayTwo *, const struct ArrayTwo *);
-static void arraytwo_free(struct ArrayTwo *);
+/* BitMatrix */
+static struct BitMatrix *bitMatrix_new(unsigned int size);
+static struct BitMatrix *bitMatrix_newcp(const struct BitMatrix *);
+static void bitMatrix_set(struct BitMatrix *, unsigned int i, unsigned int j);
+static int bitMatrix_areEqual(const struct BitMatrix *, const struct BitMatrix 
+		*);
+static uint32_t bitMatrix_hash(const struct BitMatrix *);
+static void bitMatrix_free(struct BitMatrix *);
+
+/* NodeSet */
+static struct NodeSet *nodeSet_new(unsigned int nbNodes);
+static void nodeSet_clear(struct NodeSet *);
+static inline void nodeSet_add(struct NodeSet *, unsigned int);
+static inline int nodeSet_addAtomic(struct NodeSet *, unsigned int);
+static inline void nodeSet_removeAtomic(struct NodeSet *, unsigned int);
+static inline int nodeSet_inAtomic(const struct NodeSet *, unsigned int);
+static unsigned int nodeSet_next(const struct NodeSet *, unsigned int from);
+static void nodeSet_free(struct NodeSet *);
 
 /* StringArray */
 static struct StringArray *stringArray_new(const struct Graph *);
 static struct StringArray *stringArray_newcp(const struct StringArray *);
 static struct StringArray *stringArray_newNext(const struct StringArray *prev, 
 		const struct Graph *, char);
+static void stringArray_computeHash(struct StringArray *);
+static int stringArray_areEqual(const struct StringArray *, const struct 
+		StringArray *);
 static void stringArray_free(struct StringArray *);
 
+/* StringDag */
+static struct StringDag *stringDag_new(unsigned int nbConts);
+static unsigned int stringDag_add(struct StringDag *, struct StringArray *, 
+		int *isNew);
+static void stringDag_grow(struct StringDag *);
+static unsigned long stringDag_nbWords(struct StringDag *, unsigned int);
+static void stringDag_free(struct StringDag *);
+
 /* ZoneGraph */
-static struct ZoneGraph *zoneGraph_new(const struct TimedAutomaton *);
-static struct List *zoneGraph_splitZones2(const struct Zone *, const struct Zone 
+static struct ZoneGraph *zoneGraph_new(const struct TimedAutomaton *, const 
+		struct ZoneGraph *, const struct State **, const int *, const struct 
+		GraphOptions *, struct ThreadPool *, struct GraphStats *);
+static void zoneGraph_seedFromOld(struct Refinement *, const struct ZoneGraph *, 
+		const struct ZoneGraph *, const struct State **, const int *);
+static void zoneGraph_applySplit(struct Refinement *, struct Zone *, struct List 
 		*);
-static struct List *zoneGraph_splitZones(const struct Zone *z, const struct List 
+static void zoneGraph_splitZonesSlice(void *, unsigned int, unsigned int, 
+		unsigned int);
+static int zoneGraph_isSplitStale(const struct Refinement *, const struct Zone 
+		*);
+static void zoneGraph_refineParallel(struct Refinement *, struct ThreadPool *);
+static int zoneGraph_computeSuccs(const struct ZoneGraph *, struct Zone *);
+static void zoneGraph_computeSuccsSlice(void *, unsigned int, unsigned int, 
+		unsigned int);
+static void zoneGraph_computeTimeChains(struct ZoneGraph *);
+static void zoneGraph_splitZones2(const struct Zone *, const struct Zone *, 
+		struct Dbmw *, struct Fed *);
+static struct List *zoneGraph_splitZones(const struct Zone *z, const struct 
+		ZoneSet *rho);
+static int zoneGraph_edgeReaches(const struct Zone *, const struct StateEdge 
+		*, const struct Zone *);
+static struct List *zoneGraph_pre(const struct Zone *z, const struct ZoneSet 
+		*rho);
+static struct List *zoneGraph_post(const struct Zone *z, const struct ZoneSet 
 		*rho);
-static struct List *zoneGraph_pre(const struct Zone *z, const struct List *rho);
-static struct List *zoneGraph_post(const struct Zone *z, struct List *rho);
 static void zoneGraph_save(const struct ZoneGraph *, FILE *);
 static struct ZoneGraph *zoneGraph_load(FILE *, const struct Graph *);
 static void zoneGraph_free(struct ZoneGraph *);
 
 /* Graph */
+static struct Graph *graph_build(const char *, const struct Graph *, const 
+		struct GraphOptions *);
 static void graph_createChars(const struct List *l, struct List **psymbolTable, 
 		char **pchars, struct SymbolTableEl *[256]);
-static struct Tree *graph_computeStrings(const struct Graph *);
-static void graph_computeTree(struct Tree *, const struct Graph *);
-static void graph_addNodes(struct Graph *, struct Tree *);
+static struct StringDag *graph_computeStrings(const struct Graph *);
+static void graph_allocNodes(struct Graph *, unsigned int nbNodes, unsigned int 
+		nbSuccSlices);
+static void graph_addNodes(struct Graph *, struct StringDag *, int 
+		reachableOnly);
+static const struct Zone **graph_reachableZones(const struct Graph *, unsigned 
+		int *);
 static void graph_addNodesRec(struct Graph *g, const struct Zone *z, const 
-		struct Tree *stringArrays, struct Node *pred);
+		struct StringDag *strings, unsigned int state, int isLeaf, const char 
+		*word, struct Node *pred);
 static void graph_addEmitEdges(struct Graph *);
 static void graph_addUncontEdges(struct Graph *);
 static void graph_addTimeEdges(struct Graph *);
+static void graph_buildEdges(struct Graph *);
 static unsigned int graph_contIndex(const struct Graph *g, char c);
-static void graph_computeW0(struct Graph *g, struct Set *ret);
-static void graph_attr(struct Set *ret, struct Graph *g, int player, const 
-		struct Set *U, struct List *nodes);
+static void graph_computeW0(struct Graph *g, struct NodeSet *ret, struct 
+		ThreadPool *);
+static enum Objective graph_computeObjective(const struct Graph *);
+static void graph_solveSafety(const struct Graph *, struct Attractor *, struct 
+		ThreadPool *);
+static void graph_solveCoSafety(const struct Graph *, struct Attractor *, 
+		struct ThreadPool *);
+static void graph_solveSccs(struct Graph *, struct Attractor *, struct 
+		ThreadPool *);
+static unsigned int graph_computeSccs(const struct Graph *, const struct 
+		Attractor *, struct Node **order, unsigned int *sccStart, unsigned int 
+		*sccLevel);
+static void graph_solveSccsSlice(void *, unsigned int, unsigned int, unsigned 
+		int);
+static void graph_solveSubGame(const struct Graph *, struct SubGame *, struct 
+		Attractor *, struct ThreadPool *);
+static void graph_attr(struct NodeSet *ret, const struct Graph *g, int player, 
+		const struct NodeSet *U, struct SubGame *, struct Attractor *, struct 
+		ThreadPool *);
+static void graph_attrInitSlice(void *, unsigned int, unsigned int, unsigned 
+		int);
+static void graph_attrFrontierSlice(void *, unsigned int, unsigned int, 
+		unsigned int);
+
+/* SubGame */
+static void subGame_initAll(struct SubGame *, const struct Graph *, struct 
+		Attractor *);
+static inline void subGame_push(struct SubGame *, struct Node *);
+
+/* Attractor */
+static struct Attractor *attractor_new(const struct Graph *, struct NodeSet 
+		*won);
+static void attractor_free(struct Attractor *);
+static void graph_releaseDbmwPoolsSlice(void *, unsigned int, unsigned int, 
+		unsigned int);
+static void graph_releaseDbmwPools(struct ThreadPool *);
+
+/* GraphStats */
+static void graphStats_init(struct GraphStats *);
+static double timespec_diff(const struct timespec *, const struct timespec *);
+static void graphStats_countDbmOpsSlice(void *, unsigned int, unsigned int, 
+		unsigned int);
+static unsigned long graphStats_countDbmOps(struct ThreadPool *);
+static void graphStats_startPhase(struct PhaseTimer *, struct ThreadPool *);
+static void graphStats_endPhase(struct GraphStats *, enum GraphPhase, const 
+		struct PhaseTimer *, struct ThreadPool *);
 
 /* StratNode */
 static struct StratNode *stratNode_new(const struct Node *, int, struct List *, 
@@ -404,23 +775,6 @@ static unsigned int enforcer_delayFast(struct Enforcer *, unsigned int);
 
 /* -------------------------------------------------------------------------- */
 
-/* Helper functions for ccontainers */
-static int listIn(struct List *l, void *data)
-{
-	return (list_search(l, data, eqPtr) != NULL);
-}
-
-static void listAddNoDouble(struct List *l, void *data)
-{
-	if (!listIn(l, data))
-		list_append(l, data);
-}
-
-static void removeSetFromList(struct List *l, const struct Set *s)
-{
-	set_applyToAll(s, (void (*)(void*, void*))list_remove, l);
-}
-
 
 /* Functions to use with list_search */
 #if 0
@@ -446,13 +800,6 @@ static int cmpSymId(const void *val, const void *pel)
 	return (el->id == id);
 }
 
-static int cmpEdge(const void *pe1, const void *pe2)
-{
-	const struct Edge *e1 = pe1;
-	const struct Edge *e2 = pe2;
-	return (e1->type == e2->type && e1->succ == e2->succ);
-}
-
 static int cmpZoneIndex(const void *val, const void *pz)
 {
 	const struct Zone *z = pz;
@@ -460,30 +807,9 @@ static int cmpZoneIndex(const void *val, const void *pz)
 	return (z->index == index);
 }
 
-static int cmpNodeIndex(const void *val, const void *pn)
-{
-	const struct Node *n = pn;
-	const unsigned int index = *(const int *)val;
-	return (n->index == index);
-}
-
-static int eqPtr(const void *p1, const void *p2)
-{
-	return (p1 == p2);
-}
-
-/* Used with set_applyToAll */
-static void node_setWinning(void *dummy, void *pn)
+/* The isWinning flags of all the nodes must be set */
+static void node_computeStrat(struct Node *n)
 {
-	Node *n = pn;
-	(void)dummy;
-	n->isWinning = 1;
-}
-
-static void node_computeStrat(void *dummy, void *pn)
-{
-	struct Node *n = pn;
-	(void)dummy;
 	if (n->owner == 0 && n->p0.succEmit != NULL && n->p0.succEmit->isWinning)
 		n->p0.strat = STRAT_EMIT;
 }
@@ -543,32 +869,36 @@ static void symbolTableEl_free(struct SymbolTableEl *el)
 
 /* Node */
 /* Private interface */
-static struct Node *node_new(const struct Graph *g, const struct Zone *z, const 
-		char *word, int owner)
+/**
+ * Initializes the node of index index of g, which must have been allocated by 
+ * graph_allocNodes.
+ */
+static struct Node *node_new(struct Graph *g, const struct Zone *z, const char 
+		*word, int owner, unsigned int index)
 {
-	static unsigned int nextIndex = 0;
 	int i;
-	struct Node *n = malloc(sizeof *n);
+	struct Node *n;
 
-	if (n == NULL)
+	if (index >= g->allocNodes)
 	{
-		perror("malloc node");
+		fprintf(stderr, "ERROR: node_new: no room for the node of index %u\n", 
+				index);
 		exit(EXIT_FAILURE);
 	}
+	n = &(g->nodeArray[index]);
 
 	n->z = z;
-	n->word = strdup(word);
+	n->word = wordArena_strdup(g->words, word);
 	n->owner = owner;
 	n->isAccepting = z->s->isAccepting;
 	n->isInitial = (z->s->isInitial && word[0] == '\0' && owner == 0 && 
 			dbmw_containsZero(z->dbm));
 	n->isWinning = 0;
 	n->isLeaf = 0;
-	n->edges = list_new();
-	n->index = nextIndex++;
+	n->index = index;
 	n->userData = NULL;
 	n->g = g;
-	n->realWord = node_computeRealWord(n);
+	n->realWord = node_computeRealWord(g, n->word);
 	if (n->owner == 0)
 	{
 		n->p0.strat = STRAT_DONTEMIT;
@@ -576,78 +906,56 @@ static struct Node *node_new(const struct Graph *g, const struct Zone *z, const
 		n->p0.succStopEmit = NULL;
 		n->p0.predContRcvd = NULL;
 		n->p0.predTime = NULL;
-		n->p0.predsEmit = list_new();
-		n->p0.predsUncont = list_new();
 	}
 	else
 	{
-		n->p1.predStop = NULL;
-		n->p1.succsCont = malloc(g->nbConts * sizeof *(n->p1.succsCont));
-		if (n->p1.succsCont == NULL)
+		if (g->nbSuccSlices >= g->allocSuccSlices)
 		{
-			perror("malloc node_new:n->p1.succsCont");
+			fprintf(stderr, "ERROR: node_new: no room for the successors of " 
+					"the node of index %u\n", index);
 			exit(EXIT_FAILURE);
 		}
-		for (i = 0 ; i < g->nbConts ; i++)
+		n->p1.predStop = NULL;
+		n->p1.succsCont = &(g->succTable[g->nbSuccSlices++ * (g->nbConts + 
+					g->nbUnconts)]);
+		n->p1.succsUncont = n->p1.succsCont + g->nbConts;
+		for (i = 0 ; i < g->nbConts + g->nbUnconts ; i++)
 			n->p1.succsCont[i] = NULL;
-		n->p1.succsUncont = malloc(g->nbUnconts * sizeof *(n->p1.succsUncont));
-		if (n->p1.succsUncont == NULL)
-		{
-			perror("malloc node_new:n->p1.succsUncont");
-			exit(EXIT_FAILURE);
-		}
-		for (i = 0 ; i < g->nbUnconts ; i++)
-			n->p1.succsUncont[i] = NULL;
 		n->p1.succTime = NULL;
 	}
 
 	return n;
 }
 
-static char *node_computeRealWord(const struct Node *n)
+/* The real word is allocated in the arena of g */
+static char *node_computeRealWord(struct Graph *g, const char *word)
 {
 	char *label;
-	int size = 0, i;
-	struct SymbolTableEl **syms;
-
-	syms = malloc(strlen(n->word) * sizeof *syms);
-	if (syms == NULL)
-	{
-		perror("malloc syms");
-		exit(EXIT_FAILURE);
-	}
+	size_t size = 0;
+	int i;
 
-	i = 0;
-	while (n->word[i] != '\0')
+	for (i = 0 ; word[i] != '\0' ; i++)
 	{
-		struct SymbolTableEl *s;
-		s = n->g->contsEls[(unsigned char)n->word[i]];
+		const struct SymbolTableEl *s = g->contsEls[(unsigned char)word[i]];
 		if (s == NULL)
 		{
 			fprintf(stderr, "ERROR: could not find symbol associated to %c\n", 
-					n->word[i]);
+					word[i]);
 			exit(EXIT_FAILURE);
 		}
 
 		size += s->size;
-		syms[i++] = s;
 	}
 
-	label = malloc(size + 1);
-	if (label == NULL)
-	{
-		perror("malloc label");
-		exit(EXIT_FAILURE);
-	}
-	label[0] = '\0';
-	i = 0;
-	while (n->word[i] != '\0')
+	label = wordArena_alloc(g->words, size + 1);
+	size = 0;
+	for (i = 0 ; word[i] != '\0' ; i++)
 	{
-		strcat(label, syms[i]->sym);
-		i++;
+		const struct SymbolTableEl *s = g->contsEls[(unsigned char)word[i]];
+		memcpy(label + size, s->sym, s->size);
+		size += s->size;
 	}
-
-	free(syms);
+	label[size] = '\0';
 
 	return label;
 }
@@ -660,53 +968,93 @@ static struct Node *node_succCont(const struct Graph *g, const struct Node
 	return prev->p1.succsCont[graph_contIndex(g, cont)];
 }
 
-static void node_addEdgeNoDouble(struct Node *n, enum EdgeType type, struct Node 
-		*succ)
-{
-	struct Edge searchEdge;
-	searchEdge.type = type;
-	searchEdge.succ = succ;
-	if (list_search(n->edges, &searchEdge, cmpEdge) == NULL)
-		list_append(n->edges, edge_new(type, succ));
-}
-
+/* The edges themselves are only built by graph_buildEdges, from the 
+ * successors set by the node_addEdge* functions */
 static void node_addEdgeStop(struct Node *n, struct Node *succ)
 {
 	n->p0.succStopEmit = succ;
 	succ->p1.predStop = n;
-	node_addEdgeNoDouble(n, STOPEMIT, succ);
-	/* If there is no time successor, add the reverse edge, to represent the end 
-	 * of the execution */
-	if (succ->z->timeSucc == NULL)
-		node_addEdgeNoDouble(succ, UNCONTRCVD, n);
 }
 
 static void node_addEdgeCont(struct Node *n, struct Node *succ, int i)
 {
 	n->p1.succsCont[i] = succ;
 	succ->p0.predContRcvd = n;
-	node_addEdgeNoDouble(n, CONTRCVD, succ);
 }
 
 static void node_addEdgeUncont(struct Node *n, struct Node *succ, int i)
 {
 	n->p1.succsUncont[i] = succ;
-	listAddNoDouble(succ->p0.predsUncont, n);
-	node_addEdgeNoDouble(n, UNCONTRCVD, succ);
 }
 
 static void node_addEdgeEmit(struct Node *n, struct Node *succ)
 {
 	n->p0.succEmit = succ;
-	listAddNoDouble(succ->p0.predsEmit, n);
-	node_addEdgeNoDouble(n, EMIT, succ);
 }
 
 static void node_addEdgeTime(struct Node *n, struct Node *succ)
 {
 	n->p1.succTime = succ;
 	succ->p0.predTime = n;
-	node_addEdgeNoDouble(n, TIMELPSD, succ);
+}
+
+/**
+ * Writes into succs and types the indices of the successors of n and the types 
+ * of its edges, and returns their number, at most nbConts + nbUnconts + 2. 
+ * A node of player 1 whose zone has no time successor also has an edge back 
+ * to its predecessor by STOPEMIT, to represent the end of the execution. Two 
+ * edges of the same type to the same node are only counted once.
+ */
+static unsigned int node_listEdges(const struct Node *n, unsigned int *succs, 
+		unsigned char *types)
+{
+	const struct Graph *g = n->g;
+	unsigned int i, j, nb = 0, nbSuccs;
+	struct Node *succ;
+	enum EdgeType type;
+
+	nbSuccs = (n->owner == 0) ? 2 : g->nbConts + g->nbUnconts + 2;
+	for (i = 0 ; i < nbSuccs ; i++)
+	{
+		if (n->owner == 0)
+		{
+			type = (i == 0) ? STOPEMIT : EMIT;
+			succ = (i == 0) ? n->p0.succStopEmit : n->p0.succEmit;
+		}
+		else if (i == 0)
+		{
+			type = UNCONTRCVD;
+			succ = (n->z->timeSucc == NULL) ? n->p1.predStop : NULL;
+		}
+		else if (i <= g->nbConts)
+		{
+			type = CONTRCVD;
+			succ = n->p1.succsCont[i - 1];
+		}
+		else if (i <= g->nbConts + g->nbUnconts)
+		{
+			type = UNCONTRCVD;
+			succ = n->p1.succsUncont[i - 1 - g->nbConts];
+		}
+		else
+		{
+			type = TIMELPSD;
+			succ = n->p1.succTime;
+		}
+
+		if (succ == NULL)
+			continue;
+		for (j = 0 ; j < nb && (succs[j] != succ->index || types[j] != type) 
+				; j++)
+			;
+		if (j == nb)
+		{
+			succs[nb] = succ->index;
+			types[nb++] = type;
+		}
+	}
+
+	return nb;
 }
 
 static void node_save(const struct Node *n, FILE *f)
@@ -750,7 +1098,8 @@ static void node_save(const struct Node *n, FILE *f)
 	}
 }
 
-static struct List *node_loadAll(FILE *f, const struct Graph *g)
+/* The nodes are stored in g->nodeArray, allocated by graph_allocNodes */
+static struct List *node_loadAll(FILE *f, struct Graph *g)
 {
 	struct List *nodes = list_new();
 	int i, j;
@@ -831,8 +1180,7 @@ static struct List *node_loadAll(FILE *f, const struct Graph *g)
 					zoneIndex);
 			exit(EXIT_FAILURE);
 		}
-		n = node_new(g, z, word, owner);
-		n->index = index;
+		n = node_new(g, z, word, owner, index);
 		n->isWinning = isWinning;
 		n->isLeaf = isLeaf;
 		list_append(nodes, n);
@@ -845,27 +1193,13 @@ static struct List *node_loadAll(FILE *f, const struct Graph *g)
 		struct Node *n = listIterator_val(it);
 		if (n->owner == 0)
 		{
-			struct Node *succ = list_search(nodes, 
-					&(succs[n->index].p0.succStop), cmpNodeIndex);
-			if (succ == NULL)
-			{
-				fprintf(stderr, "ERROR: node_loadAll: No node with index %u for"
-						" succStop of %u found\n", succs[n->index].p0.succStop, 
-						n->index);
-				exit(EXIT_FAILURE);
-			}
+			struct Node *succ = node_loadSucc(g, succs[n->index].p0.succStop, 
+					"succStop", n);
 			node_addEdgeStop(n, succ);
 			if (succs[n->index].p0.succEmit != -1)
 			{
-				succ = list_search(nodes, &(succs[n->index].p0.succEmit), 
-						cmpNodeIndex);
-				if (succ == NULL)
-				{
-					fprintf(stderr, "ERROR: node_loadAll: No node with index %u" 
-							" for succEmit of %u found\n", 
-							succs[n->index].p0.succEmit, n->index);
-					exit(EXIT_FAILURE);
-				}
+				succ = node_loadSucc(g, succs[n->index].p0.succEmit, 
+						"succEmit", n);
 				node_addEdgeEmit(n, succ);
 				n->p0.strat = succs[n->index].p0.strat;
 			}
@@ -877,43 +1211,22 @@ static struct List *node_loadAll(FILE *f, const struct Graph *g)
 			{
 				if (succs[n->index].p1.succsCont[i] == -1)
 					continue;
-				succ = list_search(nodes, &(succs[n->index].p1.succsCont[i]), 
-						cmpNodeIndex);
-				if (succ == NULL)
-				{
-					fprintf(stderr, "ERROR: node_loadAll: No node with index %u"
-							" for succsCont[%d] of %u found.\n", 
-							succs[n->index].p1.succsUncont[i], i, n->index);
-					exit(EXIT_FAILURE);
-				}
+				succ = node_loadSucc(g, succs[n->index].p1.succsCont[i], 
+						"succsCont", n);
 				node_addEdgeCont(n, succ, i);
 			}
 			for (i = 0 ; i < g->nbUnconts ; i++)
 			{
-				succ = list_search(nodes, &(succs[n->index].p1.succsUncont[i]), 
-						cmpNodeIndex);
-				if (succ == NULL)
-				{
-					fprintf(stderr, "ERROR: node_loadAll: No node with index %u"
-							" for succsUncont[%d] of %u found.\n", 
-							succs[n->index].p1.succsUncont[i], i, n->index);
-					exit(EXIT_FAILURE);
-				}
+				succ = node_loadSucc(g, succs[n->index].p1.succsUncont[i], 
+						"succsUncont", n);
 				node_addEdgeUncont(n, succ, i);
 			}
 			if (succs[n->index].p1.succTime == -1)
 				n->p1.succTime = NULL;
 			else
 			{
-				succ = list_search(nodes, &(succs[n->index].p1.succTime), 
-						cmpNodeIndex);
-				if (succ == NULL)
-				{
-					fprintf(stderr, "ERROR: node_loadAll: No node with index %u"
-							" for succTime of %u found.\n", 
-							succs[n->index].p1.succTime, n->index);
-					exit(EXIT_FAILURE);
-				}
+				succ = node_loadSucc(g, succs[n->index].p1.succTime, 
+						"succTime", n);
 				node_addEdgeTime(n, succ);
 			}
 
@@ -928,24 +1241,81 @@ static struct List *node_loadAll(FILE *f, const struct Graph *g)
 	return nodes;
 }
 
-static void node_free(Node *n)
+/* Returns the node of index index, successor name of n */
+static struct Node *node_loadSucc(const struct Graph *g, unsigned int index, 
+		const char *name, const struct Node *n)
 {
-	if (n->owner == 0)
+	if (index >= g->nbNodes)
 	{
-		list_free(n->p0.predsEmit, NULL);
-		list_free(n->p0.predsUncont, NULL);
+		fprintf(stderr, "ERROR: node_loadAll: No node with index %u for %s of " 
+				"%u found\n", index, name, n->index);
+		exit(EXIT_FAILURE);
 	}
-	else
+
+	return &(g->nodeArray[index]);
+}
+
+/* WordArena */
+static struct WordArena *wordArena_new(void)
+{
+	struct WordArena *ret = malloc(sizeof *ret);
+
+	if (ret == NULL)
+	{
+		perror("malloc wordArena_new:ret");
+		exit(EXIT_FAILURE);
+	}
+	ret->first = NULL;
+
+	return ret;
+}
+
+static char *wordArena_alloc(struct WordArena *a, size_t size)
+{
+	struct WordArenaBlock *b = a->first;
+	char *ret;
+
+	if (b == NULL || b->size - b->used < size)
 	{
-		free(n->p1.succsCont);
-		free(n->p1.succsUncont);
+		size_t blockSize = (size > WORDARENA_BLOCKSIZE) ? size : 
+			WORDARENA_BLOCKSIZE;
+		b = malloc(sizeof *b + blockSize);
+		if (b == NULL)
+		{
+			perror("malloc wordArena_alloc:b");
+			exit(EXIT_FAILURE);
+		}
+		b->size = blockSize;
+		b->used = 0;
+		b->next = a->first;
+		a->first = b;
 	}
 
-	list_free(n->edges, (void (*)(void *))edge_free);
+	ret = b->data + b->used;
+	b->used += size;
+
+	return ret;
+}
+
+static char *wordArena_strdup(struct WordArena *a, const char *s)
+{
+	size_t size = strlen(s) + 1;
+	char *ret = wordArena_alloc(a, size);
+
+	memcpy(ret, s, size);
+
+	return ret;
+}
 
-	free(n->word);
-	free(n->realWord);
-	free(n);
+static void wordArena_free(struct WordArena *a)
+{
+	while (a->first != NULL)
+	{
+		struct WordArenaBlock *b = a->first;
+		a->first = b->next;
+		free(b);
+	}
+	free(a);
 }
 
 /* Node public interface */
@@ -1004,81 +1374,133 @@ void *node_getData(const struct Node *n)
 	return n->userData;
 }
 
-const struct List *node_edges(const struct Node *n)
+unsigned int node_nbEdges(const struct Node *n)
+{
+	return n->g->edgesStart[n->index + 1] - n->g->edgesStart[n->index];
+}
+
+/* Returns the edge of index i of n, i < node_nbEdges(n) */
+struct Edge node_edge(const struct Node *n, unsigned int i)
 {
-	return n->edges;
+	struct Edge ret;
+	unsigned int k = n->g->edgesStart[n->index] + i;
+
+	ret.type = n->g->edgeTypes[k];
+	ret.succ = &(n->g->nodeArray[n->g->edgeSuccs[k]]);
+
+	return ret;
 }
 
 
-/* Edge */
-static struct Edge *edge_new(enum EdgeType type, struct Node *n)
+/* State */
+/**
+ * Allocates the (empty) edge tables of s, a->nbConts and a->nbUnconts must be 
+ * set.
+ */
+static void state_init(struct State *s, const struct TimedAutomaton *a)
 {
-	struct Edge *e = malloc(sizeof *e);
+	unsigned int i;
 
-	if (e == NULL)
+	s->contSuccs = NULL;
+	s->uncontSuccs = NULL;
+	s->contSuccsStart = malloc((a->nbConts + 1) * sizeof 
+			*(s->contSuccsStart));
+	s->uncontSuccsStart = malloc((a->nbUnconts + 1) * sizeof 
+			*(s->uncontSuccsStart));
+	if (s->contSuccsStart == NULL || s->uncontSuccsStart == NULL)
 	{
-		perror("malloc e");
+		perror("malloc state_init:s->contSuccsStart");
 		exit(EXIT_FAILURE);
 	}
-	e->type = type;
-	e->succ = n;
-
-	return e;
+	for (i = 0 ; i <= a->nbConts ; i++)
+		s->contSuccsStart[i] = 0;
+	for (i = 0 ; i <= a->nbUnconts ; i++)
+		s->uncontSuccsStart[i] = 0;
+	s->outEdges = NULL;
+	s->succStates = NULL;
+	s->predStates = NULL;
 }
 
-static void edge_free(struct Edge *e)
+/**
+ * Adds se after the other edges of s labelled by the event of the given index.
+ */
+static void state_addEdge(struct State *s, const struct TimedAutomaton *a, 
+		enum ContType type, unsigned int index, struct StateEdge *se)
 {
-	free(e);
-}
+	struct StateEdge ***psuccs;
+	unsigned int *start;
+	unsigned int i, n, pos;
+
+	if (type == CONTROLLABLE)
+	{
+		psuccs = &(s->contSuccs);
+		start = s->contSuccsStart;
+		n = a->nbConts;
+	}
+	else
+	{
+		psuccs = &(s->uncontSuccs);
+		start = s->uncontSuccsStart;
+		n = a->nbUnconts;
+	}
 
+	*psuccs = realloc(*psuccs, (start[n] + 1) * sizeof **psuccs);
+	if (*psuccs == NULL)
+	{
+		perror("realloc state_addEdge:psuccs");
+		exit(EXIT_FAILURE);
+	}
 
-/* State */
-static void state_save(const struct State *s, FILE *f)
+	pos = start[index + 1];
+	memmove(&((*psuccs)[pos + 1]), &((*psuccs)[pos]), (start[n] - pos) * sizeof 
+			**psuccs);
+	(*psuccs)[pos] = se;
+	for (i = index + 1 ; i <= n ; i++)
+		start[i]++;
+}
+
+static void state_save(const struct State *s, const struct TimedAutomaton *a, 
+		FILE *f)
 {
 	struct ListIterator *it;
-	unsigned int c;
+	unsigned int i;
 	
 	save_uint64(f, (uint64_t)s->index);
 	save_uint64(f, (uint64_t)(s->isInitial != 0));
 	save_uint64(f, (uint64_t)(s->isAccepting != 0));
 	save_string(f, s->name);
 
-	for (c = 0 ;  c < NBSUCCS ; c++)
+	for (it = listIterator_first(a->contsTable) ; listIterator_hasNext(it) ; it 
+			= listIterator_next(it))
 	{
-		if (s->contSuccs[c] == NULL)
-			continue;
-		fprintf(f, "%c", c);
-		save_uint64(f, (uint64_t)list_size(s->contSuccs[c]));
-		for (it = listIterator_first(s->contSuccs[c]) ; listIterator_hasNext(it) 
-				; it = listIterator_next(it))
-		{
-			struct StateEdge *e = listIterator_val(it);
-			stateEdge_save(e, f);
-		}
-		listIterator_release(it);
+		const struct SymbolTableEl *el = listIterator_val(it);
+		fprintf(f, "%c", el->c);
+		save_uint64(f, (uint64_t)(s->contSuccsStart[el->index + 1] - 
+					s->contSuccsStart[el->index]));
+		for (i = s->contSuccsStart[el->index] ; i < 
+				s->contSuccsStart[el->index + 1] ; i++)
+			stateEdge_save(s->contSuccs[i], f);
 	}
+	listIterator_release(it);
 
-	for (c = 0 ; c < NBSUCCS ; c++)
+	for (it = listIterator_first(a->uncontsTable) ; listIterator_hasNext(it) ; 
+			it = listIterator_next(it))
 	{
-		if (s->uncontSuccs[c] == NULL)
-			continue;
-		fprintf(f, "%c", c);
-		save_uint64(f, (uint64_t)list_size(s->uncontSuccs[c]));
-		for (it = listIterator_first(s->uncontSuccs[c]) ; 
-				listIterator_hasNext(it) ; it = listIterator_next(it))
-		{
-			struct StateEdge *e = listIterator_val(it);
-			stateEdge_save(e, f);
-		}
-		listIterator_release(it);
+		const struct SymbolTableEl *el = listIterator_val(it);
+		fprintf(f, "%c", el->c);
+		save_uint64(f, (uint64_t)(s->uncontSuccsStart[el->index + 1] - 
+					s->uncontSuccsStart[el->index]));
+		for (i = s->uncontSuccsStart[el->index] ; i < 
+				s->uncontSuccsStart[el->index + 1] ; i++)
+			stateEdge_save(s->uncontSuccs[i], f);
 	}
+	listIterator_release(it);
 }
 
 static void state_loadAll(FILE *f, struct TimedAutomaton *a)
 {
 	int i, j, k;
 	uint64_t nbSuccs;
-	unsigned int n;
 
 	/* a->nbStates + 1 because there is the sink state */
 	for (i = 0 ; i < a->nbStates + 1 ; i++)
@@ -1087,35 +1509,28 @@ static void state_loadAll(FILE *f, struct TimedAutomaton *a)
 		a->states[i].isInitial = load_uint64(f) != 0;
 		a->states[i].isAccepting = load_uint64(f) != 0;
 		a->states[i].name = load_string(f);
+		state_init(&(a->states[i]), a);
 
-		for (j = 0 ; j < NBSUCCS ; j++)
-		{
-			a->states[i].contSuccs[j] = NULL;
-			a->states[i].uncontSuccs[j] = NULL;
-		}
-
-		n = list_size(a->contsTable);
-		for (j = 0 ; j < n ; j++)
+		for (j = 0 ; j < a->nbConts ; j++)
 		{
 			char c = fgetc(f);
-			a->states[i].contSuccs[(unsigned char)c] = list_new();
+			unsigned int index = a->contsEls[(unsigned char)c]->index;
 			nbSuccs = load_uint64(f);
 			for (k = 0 ; k < nbSuccs ; k++)
 			{
-				list_append(a->states[i].contSuccs[(unsigned char)c], 
+				state_addEdge(&(a->states[i]), a, CONTROLLABLE, index, 
 						stateEdge_load(f, a));
 			}
 		}
 
-		n = list_size(a->uncontsTable);
-		for (j = 0 ; j < n ; j++)
+		for (j = 0 ; j < a->nbUnconts ; j++)
 		{
 			char c = fgetc(f);
-			a->states[i].uncontSuccs[(unsigned char)c] = list_new();
+			unsigned int index = a->uncontsEls[(unsigned char)c]->index;
 			nbSuccs = load_uint64(f);
 			for (k = 0 ; k < nbSuccs ; k++)
 			{
-				list_append(a->states[i].uncontSuccs[(unsigned char)c], 
+				state_addEdge(&(a->states[i]), a, UNCONTROLLABLE, index, 
 						stateEdge_load(f, a));
 			}
 		}
@@ -1123,30 +1538,146 @@ static void state_loadAll(FILE *f, struct TimedAutomaton *a)
 	a->sinkBadState = &(a->states[a->nbStates]);
 }
 
-static void state_free(struct State *s)
+/**
+ * Fills s->outEdges, s->succStates and adds s to the predStates of its 
+ * successors. The predStates of all the states of a must have been reset 
+ * beforehand.
+ */
+static void state_computeAdjacency(struct State *s, const struct 
+		TimedAutomaton *a)
 {
-	int i;
+	int i, j, k, n;
 
-	for (i = 0 ; i < NBSUCCS ; i++)
+	s->nbOutEdges = s->contSuccsStart[a->nbConts] + 
+		s->uncontSuccsStart[a->nbUnconts];
+
+	s->outEdges = malloc(s->nbOutEdges * sizeof *(s->outEdges));
+	s->succStates = malloc(s->nbOutEdges * sizeof *(s->succStates));
+	if (s->nbOutEdges > 0 && (s->outEdges == NULL || s->succStates == NULL))
 	{
-		if (s->contSuccs[i] != NULL)
-			list_free(s->contSuccs[i], NULL);
-		if (s->uncontSuccs[i] != NULL)
-			list_free(s->uncontSuccs[i], NULL);
+		perror("malloc state_computeAdjacency:s->outEdges");
+		exit(EXIT_FAILURE);
 	}
 
-	free(s->name);
-}
+	n = (a->nbConts > a->nbUnconts) ? a->nbConts : a->nbUnconts;
+	s->nbOutEdges = 0;
+	s->nbSuccStates = 0;
+	for (i = 0 ; i < n ; i++)
+	{
+		struct StateEdge **succs[2];
+		unsigned int begin[2], end[2];
+		int l;
+
+		succs[0] = s->contSuccs;
+		begin[0] = (i < a->nbConts) ? s->contSuccsStart[i] : 0;
+		end[0] = (i < a->nbConts) ? s->contSuccsStart[i + 1] : 0;
+		succs[1] = s->uncontSuccs;
+		begin[1] = (i < a->nbUnconts) ? s->uncontSuccsStart[i] : 0;
+		end[1] = (i < a->nbUnconts) ? s->uncontSuccsStart[i + 1] : 0;
+		for (l = 0 ; l < 2 ; l++)
+		{
+			for (k = begin[l] ; k < end[l] ; k++)
+			{
+				const struct StateEdge *se = succs[l][k];
+				struct State *to = &(a->states[se->to->index]);
 
+				s->outEdges[s->nbOutEdges++] = se;
 
-/* StateEdge */
-static struct StateEdge *stateEdge_new(const struct TimedAutomaton *a, const 
-		struct State *s, const struct List *constraints, const struct List 
-		*resets)
-{
-	struct ListIterator *it;
-	struct StateEdge *ret;
-	int i;
+				for (j = 0 ; j < s->nbSuccStates ; j++)
+				{
+					if (s->succStates[j] == to)
+						break;
+				}
+				if (j == s->nbSuccStates)
+				{
+					s->succStates[s->nbSuccStates++] = to;
+					to->predStates = realloc(to->predStates, 
+							(to->nbPredStates + 1) * sizeof 
+							*(to->predStates));
+					if (to->predStates == NULL)
+					{
+						perror("realloc state_computeAdjacency:to->predStates");
+						exit(EXIT_FAILURE);
+					}
+					to->predStates[to->nbPredStates++] = s;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Returns 1 if s (a state of a) and old (a state of another automaton with the 
+ * same events and clocks) have the same outgoing edges, in the same order: same 
+ * events, same guards, same resets and targets of the same name.
+ */
+static int state_haveSameEdges(const struct State *s, const struct State *old, 
+		const struct TimedAutomaton *a)
+{
+	int i;
+
+	for (i = 0 ; i < a->nbConts + 1 ; i++)
+	{
+		if (s->contSuccsStart[i] != old->contSuccsStart[i])
+			return 0;
+	}
+	for (i = 0 ; i < a->nbUnconts + 1 ; i++)
+	{
+		if (s->uncontSuccsStart[i] != old->uncontSuccsStart[i])
+			return 0;
+	}
+	for (i = 0 ; i < s->contSuccsStart[a->nbConts] ; i++)
+	{
+		if (!stateEdge_areEqual(s->contSuccs[i], old->contSuccs[i]))
+			return 0;
+	}
+	for (i = 0 ; i < s->uncontSuccsStart[a->nbUnconts] ; i++)
+	{
+		if (!stateEdge_areEqual(s->uncontSuccs[i], old->uncontSuccs[i]))
+			return 0;
+	}
+
+	return 1;
+}
+
+/* To be used with qsort on an array of State * */
+static int state_cmpName(const void *p1, const void *p2)
+{
+	const struct State *s1 = *(const struct State * const *)p1;
+	const struct State *s2 = *(const struct State * const *)p2;
+
+	return strcmp(s1->name, s2->name);
+}
+
+static void state_free(struct State *s, const struct TimedAutomaton *a)
+{
+	int i;
+
+	free(s->outEdges);
+	free(s->succStates);
+	free(s->predStates);
+
+	for (i = 0 ; i < s->contSuccsStart[a->nbConts] ; i++)
+		stateEdge_free(s->contSuccs[i]);
+	for (i = 0 ; i < s->uncontSuccsStart[a->nbUnconts] ; i++)
+		stateEdge_free(s->uncontSuccs[i]);
+	free(s->contSuccs);
+	free(s->contSuccsStart);
+	free(s->uncontSuccs);
+	free(s->uncontSuccsStart);
+
+	free(s->name);
+}
+
+
+/* StateEdge */
+static struct StateEdge *stateEdge_new(const struct TimedAutomaton *a, const 
+		struct State *s, const struct List *constraints, const struct List 
+		*resets)
+{
+	struct ListIterator *it;
+	struct StateEdge *ret;
+	int i;
 	struct Clock *clock;
 
 	ret = malloc(sizeof *ret);
@@ -1280,6 +1811,35 @@ static struct StateEdge *stateEdge_load(FILE *f, const struct TimedAutomaton *a)
 	return e;
 }
 
+/**
+ * Two edges of different automata are equal if they lead to states of the same 
+ * name with the same guard and reset the same clocks.
+ */
+static int stateEdge_areEqual(const struct StateEdge *e1, const struct 
+		StateEdge *e2)
+{
+	struct ListIterator *it1, *it2;
+	int ret;
+
+	if (strcmp(e1->to->name, e2->to->name) != 0 || !dbmw_areEqual(e1->dbm, 
+				e2->dbm) || list_size(e1->resets) != list_size(e2->resets))
+		return 0;
+
+	ret = 1;
+	for (it1 = listIterator_first(e1->resets), it2 = 
+			listIterator_first(e2->resets) ; ret && listIterator_hasNext(it1) ; 
+			it1 = listIterator_next(it1), it2 = listIterator_next(it2))
+	{
+		const struct Clock *c1 = listIterator_val(it1);
+		const struct Clock *c2 = listIterator_val(it2);
+		ret = (clock_getIndex(c1) == clock_getIndex(c2));
+	}
+	listIterator_release(it1);
+	listIterator_release(it2);
+
+	return ret;
+}
+
 static void stateEdge_free(struct StateEdge *e)
 {
 	dbmw_free(e->dbm);
@@ -1290,35 +1850,38 @@ static void stateEdge_free(struct StateEdge *e)
 
 /* Zone */
 /* Zone private interface */
-static struct Zone *zone_new(const struct State *s, struct Dbmw *dbm, const
-		struct ZoneGraph *zg)
+/* Allocates a zone of s, without its DBM */
+static struct Zone *zone_alloc(const struct State *s, const struct ZoneGraph 
+		*zg)
 {
 	int i, n;
 	struct Zone *ret = malloc(sizeof *ret);
 
 	if (ret == NULL)
 	{
-		perror("malloc zone_new:ret");
+		perror("malloc zone_alloc:ret");
 		exit(EXIT_FAILURE);
 	}
 
-	ret->dbm = dbm;
+	ret->dbm = NULL;
 	ret->s = s;
 	ret->a = zg->a;
 	ret->zg = zg;
 
 	ret->timeSucc = NULL;
+	ret->timeChain = NULL;
+	ret->timeChainLength = 0;
 	n = list_size(ret->a->contsTable);
 	ret->contSuccs = malloc(n * sizeof *(ret->contSuccs));
 	if (ret->contSuccs == NULL)
 	{
-		perror("malloc zone_new:ret->contSuccs");
+		perror("malloc zone_alloc:ret->contSuccs");
 		exit(EXIT_FAILURE);
 	}
 	ret->resetsConts = malloc(n * sizeof *(ret->resetsConts));
 	if (ret->resetsConts == NULL)
 	{
-		perror("malloc zone_new:ret->resetsConts");
+		perror("malloc zone_alloc:ret->resetsConts");
 		exit(EXIT_FAILURE);
 	}
 	for (i = 0 ; i < n ; i++)
@@ -1331,13 +1894,13 @@ static struct Zone *zone_new(const struct State *s, struct Dbmw *dbm, const
 	ret->uncontSuccs = malloc(n * sizeof *(ret->uncontSuccs));
 	if (ret->uncontSuccs == NULL)
 	{
-		perror("malloc zone_new:ret->uncontSuccs");
+		perror("malloc zone_alloc:ret->uncontSuccs");
 		exit(EXIT_FAILURE);
 	}
 	ret->resetsUnconts = malloc(n * sizeof *(ret->resetsUnconts));
 	if (ret->resetsUnconts == NULL)
 	{
-		perror("malloc zone_new:ret->resetsUnconts");
+		perror("malloc zone_alloc:ret->resetsUnconts");
 		exit(EXIT_FAILURE);
 	}
 	for (i = 0 ; i < n ; i++)
@@ -1352,14 +1915,37 @@ static struct Zone *zone_new(const struct State *s, struct Dbmw *dbm, const
 	return ret;
 }
 
+/* dbm is interned in zg->dbms, so it may be freed and must not be modified 
+ * afterwards */
+static struct Zone *zone_new(const struct State *s, struct Dbmw *dbm, const
+		struct ZoneGraph *zg)
+{
+	struct Zone *ret = zone_alloc(s, zg);
+
+	ret->dbm = dbmwTable_intern(zg->dbms, dbm);
+
+	return ret;
+}
+
+/* The copy shares the DBM of z */
 static struct Zone *zone_newcp(const struct Zone *z)
 {
-	return zone_new(z->s, dbmw_newcp(z->dbm), z->zg);
+	struct Zone *ret = zone_alloc(z->s, z->zg);
+
+	ret->dbm = dbmwTable_ref(z->zg->dbms, z->dbm);
+
+	return ret;
 }
 
 static int zone_areEqual(const struct Zone *z1, const struct Zone *z2)
 {
-	return (z1->s == z2->s && dbmw_areEqual(z1->dbm, z2->dbm));
+	/* The DBMs are interned in the same table */
+	return (z1->s == z2->s && z1->dbm == z2->dbm);
+}
+
+static uint32_t zone_hash(const struct Zone *z)
+{
+	return dbmw_hash(z->dbm) ^ (z->s->index * 0x9e3779b9U);
 }
 
 static struct Zone *zone_nextCont(const struct Zone *z, char c)
@@ -1595,7 +2181,8 @@ static void zone_free(struct Zone *z)
 
 	if (z->name != NULL)
 		free(z->name);
-	dbmw_free(z->dbm);
+	dbmwTable_release(z->zg->dbms, z->dbm);
+	free(z->timeChain);
 
 	free(z->contSuccs);
 	n = list_size(z->a->contsTable);
@@ -1654,150 +2241,539 @@ void *zone_getData(const struct Zone *z)
 }
 	
 
-/* ZoneEdge */
-static struct ZoneEdge *zoneEdge_new(enum EdgeType type, const struct Zone *z)
+/* ZoneSet */
+static struct ZoneSet *zoneSet_new(unsigned int nbStates)
 {
-	struct ZoneEdge *e = malloc(sizeof *e);
+	unsigned int i;
+	struct ZoneSet *ret = malloc(sizeof *ret);
 
-	if (e == NULL)
+	if (ret == NULL)
 	{
-		perror("malloc zoneEdge_new:e");
+		perror("malloc zoneSet_new:ret");
 		exit(EXIT_FAILURE);
 	}
 
-	e->type = type;
-	e->succ = z;
+	ret->nbBuckets = ZONESET_INITSIZE;
+	ret->buckets = malloc(ret->nbBuckets * sizeof *(ret->buckets));
+	if (ret->buckets == NULL)
+	{
+		perror("malloc zoneSet_new:ret->buckets");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0 ; i < ret->nbBuckets ; i++)
+		ret->buckets[i] = NULL;
+	ret->size = 0;
+	ret->nextSeq = 0;
+	ret->first = NULL;
+	ret->last = NULL;
 
-	return e;
+	ret->nbStates = nbStates;
+	ret->firstS = malloc(nbStates * sizeof *(ret->firstS));
+	ret->lastS = malloc(nbStates * sizeof *(ret->lastS));
+	if (ret->firstS == NULL || ret->lastS == NULL)
+	{
+		perror("malloc zoneSet_new:ret->firstS");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0 ; i < nbStates ; i++)
+	{
+		ret->firstS[i] = NULL;
+		ret->lastS[i] = NULL;
+	}
+
+	return ret;
 }
 
-static int zoneEdge_cmp(const struct ZoneEdge *e1, const struct ZoneEdge *e2)
+static void zoneSet_grow(struct ZoneSet *zs)
 {
-	return (e1->type == e2->type && e1->succ == e2->succ);
+	unsigned int i;
+	struct ZoneSetEntry *e;
+
+	free(zs->buckets);
+	zs->nbBuckets *= 2;
+	zs->buckets = malloc(zs->nbBuckets * sizeof *(zs->buckets));
+	if (zs->buckets == NULL)
+	{
+		perror("malloc zoneSet_grow:zs->buckets");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0 ; i < zs->nbBuckets ; i++)
+		zs->buckets[i] = NULL;
+
+	for (e = zs->first ; e != NULL ; e = e->next)
+	{
+		i = e->hash & (zs->nbBuckets - 1);
+		e->nextBucket = zs->buckets[i];
+		zs->buckets[i] = e;
+	}
 }
 
-static void zoneEdge_free(struct ZoneEdge *e)
+static struct ZoneSetEntry *zoneSet_find(const struct ZoneSet *zs, const 
+		struct Zone *z)
 {
-	free(e);
+	uint32_t hash = zone_hash(z);
+	struct ZoneSetEntry *e;
+
+	for (e = zs->buckets[hash & (zs->nbBuckets - 1)] ; e != NULL ; e = 
+			e->nextBucket)
+	{
+		if (e->hash == hash && zone_areEqual(e->z, z))
+			return e;
+	}
+
+	return NULL;
 }
 
+/**
+ * Returns the zone of the set equal to z (same state and same DBM), or NULL if 
+ * there is none.
+ */
+static struct Zone *zoneSet_search(const struct ZoneSet *zs, const struct Zone 
+		*z)
+{
+	struct ZoneSetEntry *e = zoneSet_find(zs, z);
 
-/* TimedAutomaton */
-static struct TimedAutomaton *timedAutomaton_new(const struct List *contsTable, 
-		const struct SymbolTableEl *contsEls[], const struct List *uncontsTable, 
-		const struct SymbolTableEl *uncontsEls[], const struct List *states, 
-		const struct List *clocks, const struct List *edges)
+	return (e == NULL) ? NULL : e->z;
+}
+
+/**
+ * Appends z to the set and returns its entry. z must not already be in the 
+ * set.
+ */
+static struct ZoneSetEntry *zoneSet_add(struct ZoneSet *zs, struct Zone *z)
 {
-	struct ListIterator *it;
-	int i, j;
-	struct TimedAutomaton *a = malloc(sizeof *a);;
+	unsigned int i;
+	struct ZoneSetEntry *e = malloc(sizeof *e);
 
-	if (a == NULL)
+	if (e == NULL)
 	{
-		perror("malloc timedAutomaton_new:a");
+		perror("malloc zoneSet_add:e");
 		exit(EXIT_FAILURE);
 	}
 
-	a->contsTable = contsTable;
-	a->contsEls = contsEls;
-	a->uncontsTable = uncontsTable;
-	a->uncontsEls = uncontsEls;
-	a->nbStates = list_size(states);
-	a->states = malloc((a->nbStates + 1) * sizeof *(a->states));
-	if (a->states == NULL)
+	if (zs->size >= zs->nbBuckets)
+		zoneSet_grow(zs);
+
+	e->z = z;
+	e->hash = zone_hash(z);
+	i = e->hash & (zs->nbBuckets - 1);
+	e->nextBucket = zs->buckets[i];
+	zs->buckets[i] = e;
+
+	e->seq = zs->nextSeq++;
+	e->heapIndex = -1;
+	e->next = NULL;
+	e->prev = zs->last;
+	if (zs->last != NULL)
+		zs->last->next = e;
+	else
+		zs->first = e;
+	zs->last = e;
+
+	i = z->s->index;
+	e->nextS = NULL;
+	e->prevS = zs->lastS[i];
+	if (zs->lastS[i] != NULL)
+		zs->lastS[i]->nextS = e;
+	else
+		zs->firstS[i] = e;
+	zs->lastS[i] = e;
+
+	zs->size++;
+
+	return e;
+}
+
+/**
+ * Removes the zone equal to z from the set and returns it (the zone is not 
+ * freed), or returns NULL if there is no such zone.
+ */
+static struct Zone *zoneSet_remove(struct ZoneSet *zs, const struct Zone *z)
+{
+	uint32_t hash = zone_hash(z);
+	struct ZoneSetEntry **pe, *e;
+	struct Zone *ret;
+
+	for (pe = &(zs->buckets[hash & (zs->nbBuckets - 1)]) ; *pe != NULL ; pe = 
+			&((*pe)->nextBucket))
 	{
-		perror("malloc timedAutomaton_new:a->states");
-		exit(EXIT_FAILURE);
+		if ((*pe)->hash == hash && zone_areEqual((*pe)->z, z))
+			break;
 	}
 
-	a->nbClocks = list_size(clocks) + 1;
-	a->clocks = malloc(a->nbClocks * sizeof *(a->clocks));
-	if (a->clocks == NULL)
+	e = *pe;
+	if (e == NULL)
+		return NULL;
+
+	*pe = e->nextBucket;
+	if (e->prev != NULL)
+		e->prev->next = e->next;
+	else
+		zs->first = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+	else
+		zs->last = e->prev;
+
+	if (e->prevS != NULL)
+		e->prevS->nextS = e->nextS;
+	else
+		zs->firstS[e->z->s->index] = e->nextS;
+	if (e->nextS != NULL)
+		e->nextS->prevS = e->prevS;
+	else
+		zs->lastS[e->z->s->index] = e->prevS;
+
+	ret = e->z;
+	free(e);
+	zs->size--;
+
+	return ret;
+}
+
+static void zoneSet_free(struct ZoneSet *zs, void (*f)(struct Zone *))
+{
+	struct ZoneSetEntry *e, *next;
+
+	for (e = zs->first ; e != NULL ; e = next)
 	{
-		perror("malloc timedAutomaton_new:a->clocks");
-		exit(EXIT_FAILURE);
+		next = e->next;
+		if (f != NULL)
+			f(e->z);
+		free(e);
 	}
+	free(zs->buckets);
+	free(zs->firstS);
+	free(zs->lastS);
+	free(zs);
+}
 
-	a->clocks[0] = clock_new(-1, 0, "0");
-	for (it = listIterator_first(clocks), i = 1 ; listIterator_hasNext(it) ; it 
-			= listIterator_next(it), i++)
+static int zoneSetEntry_cmpSeq(const void *p1, const void *p2)
+{
+	const struct ZoneSetEntry *e1 = *(const struct ZoneSetEntry * const *)p1;
+	const struct ZoneSetEntry *e2 = *(const struct ZoneSetEntry * const *)p2;
+
+	return (e1->seq > e2->seq) - (e1->seq < e2->seq);
+}
+
+/**
+ * Returns the zones of the set that belong to s or to one of the states of adj, 
+ * in insertion order, as a malloc'ed array of size *pn.
+ */
+static struct Zone **zoneSet_neighbours(const struct ZoneSet *zs, const struct 
+		State *s, const struct State **adj, unsigned int nbAdj, unsigned int 
+		*pn)
+{
+	struct ZoneSetEntry **entries;
+	struct ZoneSetEntry *e;
+	struct Zone **ret;
+	unsigned int i, n, size;
+
+	size = 16;
+	entries = malloc(size * sizeof *entries);
+	if (entries == NULL)
 	{
-		struct ParserClock *pclock = listIterator_val(it);
-		a->clocks[i] = clock_new(parserClock_getId(pclock), i, 
-				parserClock_getName(pclock));
+		perror("malloc zoneSet_neighbours:entries");
+		exit(EXIT_FAILURE);
 	}
-	listIterator_release(it);
 
-	for (it = listIterator_first(states), i = 0 ; listIterator_hasNext(it) ; it 
-			= listIterator_next(it), i++)
+	n = 0;
+	for (i = 0 ; i <= nbAdj ; i++)
 	{
-		struct ParserState *ps = listIterator_val(it);
-		struct State *s = &(a->states[i]);
-		s->parserStateId = parserState_getId(ps);
-		s->name = strdup(parserState_getName(ps));
-		s->isInitial = parserState_isInitial(ps);
-		s->isAccepting = parserState_isAccepting(ps);
-		s->index = i;
+		const struct State *s2 = (i == 0) ? s : adj[i - 1];
 
-		for (j = 0 ; j < NBSUCCS ; j++)
+		if (i > 0 && s2 == s)
+			continue;
+		for (e = zs->firstS[s2->index] ; e != NULL ; e = e->nextS)
 		{
-			s->contSuccs[j] = NULL;
-			s->uncontSuccs[j] = NULL;
+			if (n == size)
+			{
+				size *= 2;
+				entries = realloc(entries, size * sizeof *entries);
+				if (entries == NULL)
+				{
+					perror("realloc zoneSet_neighbours:entries");
+					exit(EXIT_FAILURE);
+				}
+			}
+			entries[n++] = e;
 		}
 	}
-	listIterator_release(it);
-	a->sinkBadState = &(a->states[i]);
-	a->sinkBadState->parserStateId = -1;
-	a->sinkBadState->isAccepting = 0;
-	a->sinkBadState->isInitial = 0;
-	a->sinkBadState->name = strdup("Bad");
-	a->sinkBadState->index = i;
-	for (j = 0 ; j < NBSUCCS ; j++)
+
+	qsort(entries, n, sizeof *entries, zoneSetEntry_cmpSeq);
+
+	ret = malloc((n + 1) * sizeof *ret);
+	if (ret == NULL)
 	{
-		a->sinkBadState->uncontSuccs[j] = NULL;
-		a->sinkBadState->contSuccs[j] = NULL;
+		perror("malloc zoneSet_neighbours:ret");
+		exit(EXIT_FAILURE);
 	}
+	for (i = 0 ; i < n ; i++)
+		ret[i] = entries[i]->z;
+	free(entries);
 
-	for (it = listIterator_first(a->contsTable) ; listIterator_hasNext(it) ; it 
-			= listIterator_next(it))
+	*pn = n;
+
+	return ret;
+}
+
+/* ZoneHeap */
+static struct ZoneHeap *zoneHeap_new(void)
+{
+	struct ZoneHeap *ret = malloc(sizeof *ret);
+
+	if (ret == NULL)
 	{
-		struct SymbolTableEl *el = listIterator_val(it);
-		struct List *emptyConstraints, *emptyResets;
-		emptyConstraints = list_new();
-		emptyResets = list_new();
-		for (i = 0 ; i < a->nbStates + 1 ; i++)
-			a->states[i].contSuccs[(unsigned char)el->c] = list_new();
-		list_append(a->sinkBadState->contSuccs[(unsigned char)el->c], 
-				stateEdge_new(a, a->sinkBadState, emptyConstraints, emptyResets));
-		list_free(emptyConstraints, NULL);
-		list_free(emptyResets, NULL);
+		perror("malloc zoneHeap_new:ret");
+		exit(EXIT_FAILURE);
 	}
-	listIterator_release(it);
 
-	for (it = listIterator_first(a->uncontsTable) ; listIterator_hasNext(it) ; 
-			it = listIterator_next(it))
+	ret->allocSize = ZONEHEAP_INITSIZE;
+	ret->size = 0;
+	ret->entries = malloc(ret->allocSize * sizeof *(ret->entries));
+	if (ret->entries == NULL)
 	{
-		struct SymbolTableEl *el = listIterator_val(it);
-		for (i = 0 ; i < a->nbStates + 1 ; i++)
-			a->states[i].uncontSuccs[(unsigned char)el->c] = list_new();
-		list_append(a->sinkBadState->uncontSuccs[(unsigned char)el->c], 
-				stateEdge_new(a, a->sinkBadState, list_new(), list_new()));
+		perror("malloc zoneHeap_new:ret->entries");
+		exit(EXIT_FAILURE);
 	}
-	listIterator_release(it);
 
-	for (it = listIterator_first(edges) ; listIterator_hasNext(it) ; it = 
-			listIterator_next(it))
-	{
-		const struct ParserEdge *pe = listIterator_val(it);
-		const struct ParserSymbol *psym = parserEdge_getSym(pe);
-		const struct ParserState *pfrom = parserEdge_getFrom(pe);
-		const struct ParserState *pto = parserEdge_getTo(pe);
-		int id;
-		struct State *from, *to;
-		struct SymbolTableEl *el;
+	return ret;
+}
 
-		id = parserState_getId(pfrom);
-		from = NULL;
+static void zoneHeap_swap(struct ZoneHeap *h, unsigned int i, unsigned int j)
+{
+	struct ZoneSetEntry *e = h->entries[i];
+
+	h->entries[i] = h->entries[j];
+	h->entries[j] = e;
+	h->entries[i]->heapIndex = i;
+	h->entries[j]->heapIndex = j;
+}
+
+static void zoneHeap_siftUp(struct ZoneHeap *h, unsigned int i)
+{
+	while (i > 0 && h->entries[(i - 1) / 2]->seq > h->entries[i]->seq)
+	{
+		zoneHeap_swap(h, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+}
+
+static void zoneHeap_siftDown(struct ZoneHeap *h, unsigned int i)
+{
+	for (;;)
+	{
+		unsigned int min = i;
+		unsigned int l = 2 * i + 1, r = 2 * i + 2;
+
+		if (l < h->size && h->entries[l]->seq < h->entries[min]->seq)
+			min = l;
+		if (r < h->size && h->entries[r]->seq < h->entries[min]->seq)
+			min = r;
+		if (min == i)
+			break;
+		zoneHeap_swap(h, i, min);
+		i = min;
+	}
+}
+
+/**
+ * Adds e to the heap, if it is not already in it.
+ */
+static void zoneHeap_push(struct ZoneHeap *h, struct ZoneSetEntry *e)
+{
+	if (e->heapIndex >= 0)
+		return;
+
+	if (h->size == h->allocSize)
+	{
+		h->allocSize *= 2;
+		h->entries = realloc(h->entries, h->allocSize * sizeof 
+				*(h->entries));
+		if (h->entries == NULL)
+		{
+			perror("realloc zoneHeap_push:h->entries");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	e->heapIndex = h->size;
+	h->entries[h->size++] = e;
+	zoneHeap_siftUp(h, e->heapIndex);
+}
+
+/**
+ * Removes e from the heap, if it is in it.
+ */
+static void zoneHeap_remove(struct ZoneHeap *h, struct ZoneSetEntry *e)
+{
+	unsigned int i = e->heapIndex;
+
+	if (e->heapIndex < 0)
+		return;
+
+	e->heapIndex = -1;
+	h->size--;
+	if (i == h->size)
+		return;
+
+	h->entries[i] = h->entries[h->size];
+	h->entries[i]->heapIndex = i;
+	zoneHeap_siftUp(h, i);
+	zoneHeap_siftDown(h, h->entries[i]->heapIndex);
+}
+
+/**
+ * Returns the zone of the oldest entry of the heap, or NULL if it is empty.
+ */
+static struct Zone *zoneHeap_top(const struct ZoneHeap *h)
+{
+	return (h->size == 0) ? NULL : h->entries[0]->z;
+}
+
+static void zoneHeap_free(struct ZoneHeap *h)
+{
+	unsigned int i;
+
+	for (i = 0 ; i < h->size ; i++)
+		h->entries[i]->heapIndex = -1;
+	free(h->entries);
+	free(h);
+}
+
+/* ZoneEdge */
+static struct ZoneEdge *zoneEdge_new(enum EdgeType type, const struct Zone *z)
+{
+	struct ZoneEdge *e = malloc(sizeof *e);
+
+	if (e == NULL)
+	{
+		perror("malloc zoneEdge_new:e");
+		exit(EXIT_FAILURE);
+	}
+
+	e->type = type;
+	e->succ = z;
+
+	return e;
+}
+
+static int zoneEdge_cmp(const struct ZoneEdge *e1, const struct ZoneEdge *e2)
+{
+	return (e1->type == e2->type && e1->succ == e2->succ);
+}
+
+static void zoneEdge_free(struct ZoneEdge *e)
+{
+	free(e);
+}
+
+
+/* TimedAutomaton */
+static struct TimedAutomaton *timedAutomaton_new(const struct List *contsTable, 
+		const struct SymbolTableEl *contsEls[], const struct List *uncontsTable, 
+		const struct SymbolTableEl *uncontsEls[], const struct List *states, 
+		const struct List *clocks, const struct List *edges)
+{
+	struct ListIterator *it;
+	int i;
+	struct TimedAutomaton *a = malloc(sizeof *a);;
+
+	if (a == NULL)
+	{
+		perror("malloc timedAutomaton_new:a");
+		exit(EXIT_FAILURE);
+	}
+
+	a->contsTable = contsTable;
+	a->contsEls = contsEls;
+	a->uncontsTable = uncontsTable;
+	a->uncontsEls = uncontsEls;
+	a->nbConts = list_size(contsTable);
+	a->nbUnconts = list_size(uncontsTable);
+	a->nbStates = list_size(states);
+	a->states = malloc((a->nbStates + 1) * sizeof *(a->states));
+	if (a->states == NULL)
+	{
+		perror("malloc timedAutomaton_new:a->states");
+		exit(EXIT_FAILURE);
+	}
+
+	a->nbClocks = list_size(clocks) + 1;
+	a->clocks = malloc(a->nbClocks * sizeof *(a->clocks));
+	if (a->clocks == NULL)
+	{
+		perror("malloc timedAutomaton_new:a->clocks");
+		exit(EXIT_FAILURE);
+	}
+
+	a->clocks[0] = clock_new(-1, 0, "0");
+	for (it = listIterator_first(clocks), i = 1 ; listIterator_hasNext(it) ; it 
+			= listIterator_next(it), i++)
+	{
+		struct ParserClock *pclock = listIterator_val(it);
+		a->clocks[i] = clock_new(parserClock_getId(pclock), i, 
+				parserClock_getName(pclock));
+	}
+	listIterator_release(it);
+
+	for (it = listIterator_first(states), i = 0 ; listIterator_hasNext(it) ; it 
+			= listIterator_next(it), i++)
+	{
+		struct ParserState *ps = listIterator_val(it);
+		struct State *s = &(a->states[i]);
+		s->parserStateId = parserState_getId(ps);
+		s->name = strdup(parserState_getName(ps));
+		s->isInitial = parserState_isInitial(ps);
+		s->isAccepting = parserState_isAccepting(ps);
+		s->index = i;
+		state_init(s, a);
+	}
+	listIterator_release(it);
+	a->sinkBadState = &(a->states[i]);
+	a->sinkBadState->parserStateId = -1;
+	a->sinkBadState->isAccepting = 0;
+	a->sinkBadState->isInitial = 0;
+	a->sinkBadState->name = strdup("Bad");
+	a->sinkBadState->index = i;
+	state_init(a->sinkBadState, a);
+
+	for (it = listIterator_first(a->contsTable) ; listIterator_hasNext(it) ; it 
+			= listIterator_next(it))
+	{
+		struct SymbolTableEl *el = listIterator_val(it);
+		struct List *emptyConstraints, *emptyResets;
+		emptyConstraints = list_new();
+		emptyResets = list_new();
+		state_addEdge(a->sinkBadState, a, CONTROLLABLE, el->index, 
+				stateEdge_new(a, a->sinkBadState, emptyConstraints, emptyResets));
+		list_free(emptyConstraints, NULL);
+		list_free(emptyResets, NULL);
+	}
+	listIterator_release(it);
+
+	for (it = listIterator_first(a->uncontsTable) ; listIterator_hasNext(it) ; 
+			it = listIterator_next(it))
+	{
+		struct SymbolTableEl *el = listIterator_val(it);
+		state_addEdge(a->sinkBadState, a, UNCONTROLLABLE, el->index, 
+				stateEdge_new(a, a->sinkBadState, list_new(), list_new()));
+	}
+	listIterator_release(it);
+
+	for (it = listIterator_first(edges) ; listIterator_hasNext(it) ; it = 
+			listIterator_next(it))
+	{
+		const struct ParserEdge *pe = listIterator_val(it);
+		const struct ParserSymbol *psym = parserEdge_getSym(pe);
+		const struct ParserState *pfrom = parserEdge_getFrom(pe);
+		const struct ParserState *pto = parserEdge_getTo(pe);
+		int id;
+		struct State *from, *to;
+		struct SymbolTableEl *el;
+
+		id = parserState_getId(pfrom);
+		from = NULL;
 		for (i = 0 ; i < a->nbStates ; i++)
 		{
 			if (a->states[i].parserStateId == id)
@@ -1837,7 +2813,7 @@ static struct TimedAutomaton *timedAutomaton_new(const struct List *contsTable,
 			}
 			se = stateEdge_new(a, to, parserEdge_getConstraints(pe), 
 					parserEdge_getResets(pe));
-			list_append(from->contSuccs[(unsigned char)el->c], se);
+			state_addEdge(from, a, CONTROLLABLE, el->index, se);
 		}
 		else
 		{
@@ -1851,14 +2827,156 @@ static struct TimedAutomaton *timedAutomaton_new(const struct List *contsTable,
 			}
 			se = stateEdge_new(a, to, parserEdge_getConstraints(pe), 
 					parserEdge_getResets(pe));
-			list_append(from->uncontSuccs[(unsigned char)el->c], se);
+			state_addEdge(from, a, UNCONTROLLABLE, el->index, se);
 		}
 	}
 	listIterator_release(it);
 
+	timedAutomaton_computeAdjacency(a);
+
 	return a;
 }
 
+static void timedAutomaton_computeAdjacency(struct TimedAutomaton *a)
+{
+	int i;
+
+	for (i = 0 ; i < a->nbStates + 1 ; i++)
+	{
+		a->states[i].predStates = NULL;
+		a->states[i].nbPredStates = 0;
+	}
+	for (i = 0 ; i < a->nbStates + 1 ; i++)
+		state_computeAdjacency(&(a->states[i]), a);
+}
+
+/**
+ * Compares a with old, an earlier version of the same automaton. Returns an 
+ * array that maps the index of each state of a to the state of old of the same 
+ * name, or to NULL if the state is new, or if its initial flag or its outgoing 
+ * edges changed: the zones of old for this state must be computed again. The 
+ * zones of old for the states that can reach such a state are kept, but may 
+ * have to be split again: unstable[i] is set to 1 for them, and to 0 for the 
+ * other states. Returns NULL if a and old do not have the same events or 
+ * clocks, or if more than half of the states are new, changed, or can reach 
+ * such a state.
+ */
+static const struct State **timedAutomaton_diff(const struct TimedAutomaton *a, 
+		const struct TimedAutomaton *old, int *unstable)
+{
+	const struct State **ret, **oldSorted, **stack;
+	const struct State *s, *key;
+	struct ListIterator *it1, *it2;
+	int *dirty;
+	unsigned int i, j, n;
+	int same;
+
+	if (a->nbClocks != old->nbClocks || a->nbConts != old->nbConts || 
+			a->nbUnconts != old->nbUnconts)
+		return NULL;
+	for (i = 1 ; i < a->nbClocks ; i++)
+	{
+		if (strcmp(clock_getName(a->clocks[i]), clock_getName(old->clocks[i])) 
+				!= 0)
+			return NULL;
+	}
+	same = 1;
+	for (it1 = listIterator_first(a->contsTable), it2 = 
+			listIterator_first(old->contsTable) ; same && 
+			listIterator_hasNext(it1) ; it1 = listIterator_next(it1), it2 = 
+			listIterator_next(it2))
+	{
+		const struct SymbolTableEl *el1 = listIterator_val(it1);
+		const struct SymbolTableEl *el2 = listIterator_val(it2);
+		same = (el1->index == el2->index && strcmp(el1->sym, el2->sym) == 0);
+	}
+	listIterator_release(it1);
+	listIterator_release(it2);
+	for (it1 = listIterator_first(a->uncontsTable), it2 = 
+			listIterator_first(old->uncontsTable) ; same && 
+			listIterator_hasNext(it1) ; it1 = listIterator_next(it1), it2 = 
+			listIterator_next(it2))
+	{
+		const struct SymbolTableEl *el1 = listIterator_val(it1);
+		const struct SymbolTableEl *el2 = listIterator_val(it2);
+		same = (el1->index == el2->index && strcmp(el1->sym, el2->sym) == 0);
+	}
+	listIterator_release(it1);
+	listIterator_release(it2);
+	if (!same)
+		return NULL;
+
+	ret = malloc(a->nbStates * sizeof *ret);
+	oldSorted = malloc(old->nbStates * sizeof *oldSorted);
+	stack = malloc(a->nbStates * sizeof *stack);
+	dirty = calloc(a->nbStates + 1, sizeof *dirty);
+	if (ret == NULL || oldSorted == NULL || stack == NULL || dirty == NULL)
+	{
+		perror("malloc timedAutomaton_diff:ret");
+		exit(EXIT_FAILURE);
+	}
+
+	for (i = 0 ; i < old->nbStates ; i++)
+		oldSorted[i] = &(old->states[i]);
+	qsort(oldSorted, old->nbStates, sizeof *oldSorted, state_cmpName);
+
+	/* States that changed */
+	n = 0;
+	for (i = 0 ; i < a->nbStates ; i++)
+	{
+		const struct State **p;
+
+		unstable[i] = 0;
+		s = &(a->states[i]);
+		key = s;
+		p = bsearch(&key, oldSorted, old->nbStates, sizeof *oldSorted, 
+				state_cmpName);
+		ret[i] = (p != NULL) ? *p : NULL;
+		if (ret[i] == NULL || ret[i]->isInitial != s->isInitial || 
+				!state_haveSameEdges(s, ret[i], a))
+		{
+			ret[i] = NULL;
+			dirty[i] = 1;
+			stack[n++] = s;
+		}
+	}
+
+	/* States that can reach them */
+	while (n > 0)
+	{
+		s = stack[--n];
+		for (j = 0 ; j < s->nbPredStates ; j++)
+		{
+			const struct State *pred = s->predStates[j];
+			if (!dirty[pred->index])
+			{
+				dirty[pred->index] = 1;
+				unstable[pred->index] = 1;
+				stack[n++] = pred;
+			}
+		}
+	}
+
+	/* Most of the zones would be split again: starting from the zones of old 
+	 * would then cost more than starting from scratch */
+	for (i = 0, n = 0 ; i < a->nbStates ; i++)
+	{
+		if (dirty[i])
+			n++;
+	}
+	if (2 * n > a->nbStates)
+	{
+		free(ret);
+		ret = NULL;
+	}
+
+	free(oldSorted);
+	free(stack);
+	free(dirty);
+
+	return ret;
+}
+
 static void timedAutomaton_save(const struct TimedAutomaton *a, FILE *f)
 {
 	int i;
@@ -1873,7 +2991,7 @@ static void timedAutomaton_save(const struct TimedAutomaton *a, FILE *f)
 	/* Add 1 for the sink state */
 	for (i = 0 ; i < a->nbStates + 1 ; i++)
 	{
-		state_save(&(a->states[i]), f);
+		state_save(&(a->states[i]), a, f);
 	}
 }
 
@@ -1894,6 +3012,8 @@ static struct TimedAutomaton *timedAutomaton_load(FILE *f, const struct Graph
 	a->contsEls = (const struct SymbolTableEl **)g->contsEls;
 	a->uncontsTable = g->uncontsTable;
 	a->uncontsEls = (const struct SymbolTableEl **)g->uncontsEls;
+	a->nbConts = list_size(a->contsTable);
+	a->nbUnconts = list_size(a->uncontsTable);
 
 	a->nbClocks = (unsigned int)load_uint64(f);
 	a->clocks = malloc(a->nbClocks * sizeof *(a->clocks));
@@ -1916,41 +3036,16 @@ static struct TimedAutomaton *timedAutomaton_load(FILE *f, const struct Graph
 		exit(EXIT_FAILURE);
 	}
 	state_loadAll(f, a);
+	timedAutomaton_computeAdjacency(a);
 
 	return a;
 }
 
 static void timedAutomaton_free(struct TimedAutomaton *a)
 {
-	int i, j;
+	int i;
 	for (i = 0 ; i < a->nbStates + 1 ; i++)
-	{
-		for (j = 0 ; j < NBSUCCS ; j++)
-		{
-			struct ListIterator *it;
-			if (a->states[i].contSuccs[j] != NULL)
-			{
-				for (it = listIterator_first(a->states[i].contSuccs[j]) ; 
-						listIterator_hasNext(it) ; it = listIterator_next(it))
-				{
-					struct StateEdge *se = listIterator_val(it);
-					stateEdge_free(se);
-				}
-				listIterator_release(it);
-			}
-			if (a->states[i].uncontSuccs[j] != NULL)
-			{
-				for (it = listIterator_first(a->states[i].uncontSuccs[j]) ; 
-						listIterator_hasNext(it) ; it = listIterator_next(it))
-				{
-					struct StateEdge *se = listIterator_val(it);
-					stateEdge_free(se);
-				}
-				listIterator_release(it);
-			}
-		}
-		state_free(&(a->states[i]));
-	}
+		state_free(&(a->states[i]), a);
 	free(a->states);
 
 	for (i = 0 ; i < a->nbClocks ; i++)
@@ -1962,123 +3057,173 @@ static void timedAutomaton_free(struct TimedAutomaton *a)
 	free(a);
 }
 
-/* ArrayTwo */
-static struct ArrayTwo *arraytwo_new(unsigned int size, int defaultVal)
+/* BitMatrix */
+static struct BitMatrix *bitMatrix_new(unsigned int size)
 {
-	int i, j;
-	struct ArrayTwo *ret = malloc(sizeof *ret);
+	struct BitMatrix *ret = malloc(sizeof *ret);
 
 	if (ret == NULL)
 	{
-		perror("malloc arraytwo_new:ret");
+		perror("malloc bitMatrix_new:ret");
 		exit(EXIT_FAILURE);
 	}
-	ret->allocSize = size;
-	ret->size = ret->allocSize;
+	ret->size = size;
+	ret->rowWords = (size + 63) / 64;
 
-	ret->tab = malloc(ret->allocSize * sizeof *(ret->tab));
-	if (ret->tab == NULL)
+	ret->bits = calloc((size_t)size * ret->rowWords, sizeof *(ret->bits));
+	if (ret->bits == NULL && size > 0)
 	{
-		perror("malloc arraytwo_new:ret->tab");
+		perror("calloc bitMatrix_new:ret->bits");
 		exit(EXIT_FAILURE);
 	}
-	
-	for (i = 0 ; i < size ; i++)
+
+	return ret;
+}
+
+static struct BitMatrix *bitMatrix_newcp(const struct BitMatrix *other)
+{
+	struct BitMatrix *copy = malloc(sizeof *copy);
+	size_t nbWords = (size_t)other->size * other->rowWords;
+
+	if (copy == NULL)
 	{
-		ret->tab[i] = malloc(size * sizeof *(ret->tab[i]));
-		if (ret->tab[i] == NULL)
-		{
-			perror("malloc arraytwo_new:ret->tab[i]");
-			exit(EXIT_FAILURE);
-		}
+		perror("malloc bitMatrix_newcp:copy");
+		exit(EXIT_FAILURE);
+	}
+	copy->size = other->size;
+	copy->rowWords = other->rowWords;
 
-		for (j = 0 ; j < size ; j++)
-		{
-			ret->tab[i][j] = defaultVal;
-		}
+	copy->bits = malloc(nbWords * sizeof *(copy->bits));
+	if (copy->bits == NULL && nbWords > 0)
+	{
+		perror("malloc bitMatrix_newcp:copy->bits");
+		exit(EXIT_FAILURE);
 	}
+	memcpy(copy->bits, other->bits, nbWords * sizeof *(copy->bits));
 
-	return ret;
+	return copy;
 }
 
-static struct ArrayTwo *arraytwo_newcp(const struct ArrayTwo *other)
+static void bitMatrix_set(struct BitMatrix *m, unsigned int i, unsigned int j)
 {
-	struct ArrayTwo *copy = arraytwo_new(other->size, 0);
-	arraytwo_cp(copy, other);
+	m->bits[(size_t)i * m->rowWords + j / 64] |= (uint64_t)1 << (j % 64);
+}
 
-	return copy;
+/* The padding bits are never set, so whole words can be compared */
+static int bitMatrix_areEqual(const struct BitMatrix *m1, const struct 
+		BitMatrix *m2)
+{
+	if (m1->size != m2->size)
+		return 0;
+
+	return (memcmp(m1->bits, m2->bits, (size_t)m1->size * m1->rowWords * 
+				sizeof *(m1->bits)) == 0);
 }
 
-static void arraytwo_cp(struct ArrayTwo *dest, const struct ArrayTwo *src)
+static uint32_t bitMatrix_hash(const struct BitMatrix *m)
 {
-	int i, j;
+	size_t i, nbWords = (size_t)m->size * m->rowWords;
+	uint64_t h = 14695981039346656037ULL;
 
-	if (dest->allocSize < src->size)
+	for (i = 0 ; i < nbWords ; i++)
 	{
-		dest->allocSize = src->size;
-		dest->tab = realloc(dest->tab, dest->allocSize * sizeof *(dest->tab));
-		if (dest->tab == NULL)
-		{
-			perror("realloc arraytwo_cp:dest->tab");
-			exit(EXIT_FAILURE);
-		}
-		for (i = 0 ; i < dest->allocSize ; i++)
-		{
-			dest->tab[i] = realloc(dest->tab[i], dest->allocSize * sizeof 
-					*(dest->tab[i]));
-			if (dest->tab[i] == NULL)
-			{
-				perror("realloc arraytwo_cp:dest->tab[i]");
-				exit(EXIT_FAILURE);
-			}
-		}
+		h ^= m->bits[i];
+		h *= 1099511628211ULL;
 	}
 
-	dest->size = src->size;
+	return (uint32_t)(h ^ (h >> 32));
+}
 
-	for (i = 0 ; i < dest->size ; i++)
-	{
-		for (j = 0 ; j < dest->size ; j++)
-		{
-			dest->tab[i][j] = src->tab[i][j];
-		}
-	}
+static void bitMatrix_free(struct BitMatrix *m)
+{
+	free(m->bits);
+	free(m);
 }
 
-static int arraytwo_cmp(const struct ArrayTwo *a1, const struct ArrayTwo *a2)
+/* NodeSet */
+static struct NodeSet *nodeSet_new(unsigned int nbNodes)
 {
-	int i, j;
+	struct NodeSet *ret = malloc(sizeof *ret);
 
-	if (a1->size != a2->size)
-		return 0;
+	if (ret == NULL)
+	{
+		perror("malloc nodeSet_new:ret");
+		exit(EXIT_FAILURE);
+	}
+	ret->nbNodes = nbNodes;
+	ret->nbWords = (nbNodes + 63) / 64;
 
-	for (i = 0 ; i < a1->size ; i++)
+	ret->bits = calloc(ret->nbWords, sizeof *(ret->bits));
+	if (ret->bits == NULL && ret->nbWords > 0)
 	{
-		for (j = 0 ; j < a1->size ; j++)
-		{
-			if (a1->tab[i][j] != a2->tab[i][j])
-				return 0;
-		}
+		perror("calloc nodeSet_new:ret->bits");
+		exit(EXIT_FAILURE);
 	}
 
-	return 1;
+	return ret;
 }
 
-static void arraytwo_free(struct ArrayTwo *a)
+static void nodeSet_clear(struct NodeSet *s)
 {
-	int i;
-	for (i = 0 ; i < a->size ; i++)
+	memset(s->bits, 0, s->nbWords * sizeof *(s->bits));
+}
+
+static inline void nodeSet_add(struct NodeSet *s, unsigned int i)
+{
+	s->bits[i / 64] |= (uint64_t)1 << (i % 64);
+}
+
+/* Returns 1 if i was not in s yet. Safe with the other atomic functions */
+static inline int nodeSet_addAtomic(struct NodeSet *s, unsigned int i)
+{
+	uint64_t bit = (uint64_t)1 << (i % 64);
+
+	return ((__atomic_fetch_or(&(s->bits[i / 64]), bit, __ATOMIC_RELAXED) & 
+				bit) == 0);
+}
+
+static inline void nodeSet_removeAtomic(struct NodeSet *s, unsigned int i)
+{
+	__atomic_fetch_and(&(s->bits[i / 64]), ~((uint64_t)1 << (i % 64)), 
+			__ATOMIC_RELAXED);
+}
+
+static inline int nodeSet_inAtomic(const struct NodeSet *s, unsigned int i)
+{
+	return (__atomic_load_n(&(s->bits[i / 64]), __ATOMIC_RELAXED) >> (i % 64)) 
+		& 1;
+}
+
+/**
+ * Returns the smallest node index of s greater or equal to from, or 
+ * s->nbNodes if there is none.
+ */
+static unsigned int nodeSet_next(const struct NodeSet *s, unsigned int from)
+{
+	unsigned int i = from / 64;
+	uint64_t w;
+
+	if (from >= s->nbNodes)
+		return s->nbNodes;
+	w = s->bits[i] & (~(uint64_t)0 << (from % 64));
+	while (w == 0)
 	{
-		free(a->tab[i]);
+		if (++i == s->nbWords)
+			return s->nbNodes;
+		w = s->bits[i];
 	}
-	free(a->tab);
-	free(a);
+
+	return i * 64 + (unsigned int)__builtin_ctzll(w);
 }
 
-/** Do not call the stringArray_ functions when the graph has been loaded and 
- * not computed, the only information that is stored is the buffer (sa->s), the 
- * other fields are only necessary to compute the graph. In this case, only call 
- * stringArray_load */
+static void nodeSet_free(struct NodeSet *s)
+{
+	free(s->bits);
+	free(s);
+}
+
+/** The stringArray_ and stringDag_ functions are only used to compute the 
+ * graph: a loaded graph only stores the word of each node. */
 static struct StringArray *stringArray_new(const struct Graph *g)
 {
 	int i;
@@ -2092,8 +3237,7 @@ static struct StringArray *stringArray_new(const struct Graph *g)
 		exit(EXIT_FAILURE);
 	}
 	
-	ret->array = arraytwo_new(size, 0);
-	ret->s = strdup("");
+	ret->array = bitMatrix_new(size);
 	ret->size = size;
 	ret->lasts = malloc(ret->size * sizeof *(ret->lasts));
 	if (ret->lasts == NULL)
@@ -2106,17 +3250,17 @@ static struct StringArray *stringArray_new(const struct Graph *g)
 			listIterator_hasNext(it) ; it = listIterator_next(it), i++)
 	{
 		const struct Zone *z = listIterator_val(it);
-		ret->array->tab[i][i] = 1;
+		bitMatrix_set(ret->array, i, i);
 		ret->lasts[i] = z;
 	}
 	listIterator_release(it);
+	stringArray_computeHash(ret);
 
 	return ret;
 }
 
 static struct StringArray *stringArray_newcp(const struct StringArray *sa)
 {
-	int i;
 	struct StringArray *ret = malloc(sizeof *ret);
 
 	if (ret == NULL)
@@ -2126,8 +3270,7 @@ static struct StringArray *stringArray_newcp(const struct StringArray *sa)
 	}
 
 	ret->size = sa->size;
-	ret->array = arraytwo_newcp(sa->array);
-	ret->s = strdup(sa->s);
+	ret->array = bitMatrix_newcp(sa->array);
 	ret->lasts = malloc(ret->size * sizeof *(ret->lasts));
 	if (ret->lasts == NULL)
 	{
@@ -2135,11 +3278,8 @@ static struct StringArray *stringArray_newcp(const struct StringArray *sa)
 		exit(EXIT_FAILURE);
 	}
 
-	for (i = 0 ; i < ret->size ; i++)
-	{
-		ret->array->tab[i][i] = 1;
-		ret->lasts[i] = sa->lasts[i];
-	}
+	memcpy(ret->lasts, sa->lasts, ret->size * sizeof *(ret->lasts));
+	ret->hash = sa->hash;
 	
 	return ret;
 }
@@ -2156,50 +3296,663 @@ static struct StringArray *stringArray_newNext(const struct StringArray *prev,
 		exit(EXIT_FAILURE);
 	}
 
-	ret->s = realloc(ret->s, strlen(ret->s) + 2);
-	if (ret->s == NULL)
+	for (i = 0 ; i < g->zoneGraph->nbZones ; i++)
+	{
+		const struct Zone *last = ret->lasts[i];
+		const struct Zone *next = zone_nextCont(last, c);
+		bitMatrix_set(ret->array, i, next->index);
+		ret->lasts[i] = next;
+	}
+	stringArray_computeHash(ret);
+
+	return ret;
+}
+
+static void stringArray_computeHash(struct StringArray *sa)
+{
+	uint32_t h = bitMatrix_hash(sa->array);
+	unsigned int i;
+
+	for (i = 0 ; i < sa->size ; i++)
+		h = h * 31 + sa->lasts[i]->index;
+	sa->hash = h;
+}
+
+static int stringArray_areEqual(const struct StringArray *sa1, const struct 
+		StringArray *sa2)
+{
+	return (sa1->hash == sa2->hash && sa1->size == sa2->size && 
+			memcmp(sa1->lasts, sa2->lasts, sa1->size * sizeof *(sa1->lasts)) == 
+			0 && bitMatrix_areEqual(sa1->array, sa2->array));
+}
+
+static void stringArray_free(struct StringArray *sa)
+{
+	bitMatrix_free(sa->array);
+	free(sa->lasts);
+	free(sa);
+}
+
+/* StringDag */
+static struct StringDag *stringDag_new(unsigned int nbConts)
+{
+	struct StringDag *ret = malloc(sizeof *ret);
+
+	if (ret == NULL)
+	{
+		perror("malloc stringDag_new:ret");
+		exit(EXIT_FAILURE);
+	}
+
+	ret->nbConts = nbConts;
+	ret->nbStates = 0;
+	ret->allocStates = STRINGDAG_INITSIZE;
+	ret->states = malloc(ret->allocStates * sizeof *(ret->states));
+	ret->succs = malloc(ret->allocStates * nbConts * sizeof *(ret->succs));
+	ret->expand = malloc(ret->allocStates * nbConts * sizeof *(ret->expand));
+	ret->nbWords = NULL;
+	ret->nbBuckets = STRINGDAG_INITSIZE;
+	ret->buckets = calloc(ret->nbBuckets, sizeof *(ret->buckets));
+	if (ret->states == NULL || (nbConts > 0 && (ret->succs == NULL || 
+					ret->expand == NULL)) || ret->buckets == NULL)
+	{
+		perror("malloc stringDag_new:ret->states");
+		exit(EXIT_FAILURE);
+	}
+
+	return ret;
+}
+
+/**
+ * Returns the index of the state equal to sa, and sets *isNew to 0 after 
+ * freeing sa if there was already one. Otherwise sa is added to the DAG and 
+ * *isNew is set to 1.
+ */
+static unsigned int stringDag_add(struct StringDag *d, struct StringArray *sa, 
+		int *isNew)
+{
+	struct StringArray *e;
+	unsigned int i;
+
+	for (e = d->buckets[sa->hash & (d->nbBuckets - 1)] ; e != NULL ; e = 
+			e->nextBucket)
+	{
+		if (stringArray_areEqual(e, sa))
+		{
+			stringArray_free(sa);
+			*isNew = 0;
+			return e->index;
+		}
+	}
+
+	if (d->nbStates == d->allocStates)
+		stringDag_grow(d);
+
+	i = sa->hash & (d->nbBuckets - 1);
+	sa->nextBucket = d->buckets[i];
+	d->buckets[i] = sa;
+	sa->index = d->nbStates;
+	sa->isExtended = 0;
+	d->states[d->nbStates] = sa;
+	*isNew = 1;
+
+	return d->nbStates++;
+}
+
+/* Doubles the number of states and of buckets */
+static void stringDag_grow(struct StringDag *d)
+{
+	unsigned int i;
+
+	d->allocStates *= 2;
+	d->states = realloc(d->states, d->allocStates * sizeof *(d->states));
+	d->succs = realloc(d->succs, d->allocStates * d->nbConts * sizeof 
+			*(d->succs));
+	d->expand = realloc(d->expand, d->allocStates * d->nbConts * sizeof 
+			*(d->expand));
+	if (d->states == NULL || (d->nbConts > 0 && (d->succs == NULL || d->expand 
+					== NULL)))
+	{
+		perror("realloc stringDag_grow:d->states");
+		exit(EXIT_FAILURE);
+	}
+
+	free(d->buckets);
+	d->nbBuckets = d->allocStates;
+	d->buckets = calloc(d->nbBuckets, sizeof *(d->buckets));
+	if (d->buckets == NULL)
+	{
+		perror("calloc stringDag_grow:d->buckets");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0 ; i < d->nbStates ; i++)
+	{
+		struct StringArray *sa = d->states[i];
+		unsigned int j = sa->hash & (d->nbBuckets - 1);
+		sa->nextBucket = d->buckets[j];
+		d->buckets[j] = sa;
+	}
+}
+
+/**
+ * Returns the number of words of the subtree of the extended state of index 
+ * state, including the word of the state itself. It must only be called once 
+ * all the states are added.
+ */
+static unsigned long stringDag_nbWords(struct StringDag *d, unsigned int state)
+{
+	unsigned int i;
+	unsigned long n = 1;
+
+	if (d->nbWords == NULL)
+	{
+		d->nbWords = calloc(d->nbStates, sizeof *(d->nbWords));
+		if (d->nbWords == NULL)
+		{
+			perror("calloc stringDag_nbWords:d->nbWords");
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (d->nbWords[state] != 0)
+		return d->nbWords[state];
+
+	for (i = 0 ; i < d->nbConts ; i++)
+	{
+		unsigned int k = state * d->nbConts + i;
+		n += (d->expand[k]) ? stringDag_nbWords(d, d->succs[k]) : 1;
+	}
+	d->nbWords[state] = n;
+
+	return n;
+}
+
+static void stringDag_free(struct StringDag *d)
+{
+	unsigned int i;
+
+	for (i = 0 ; i < d->nbStates ; i++)
+		stringArray_free(d->states[i]);
+	free(d->states);
+	free(d->succs);
+	free(d->expand);
+	free(d->nbWords);
+	free(d->buckets);
+	free(d);
+}
+
+
+/* ZoneGraph */
+/* ZoneGraph private interface */
+/**
+ * Computes the name and the successors of z in zg, whose zones must be indexed 
+ * already. Only z is modified, so that this can be called concurrently on 
+ * different zones.
+ * @ret 1 if z has an edge to the sink zone, 0 otherwise
+ */
+static int zoneGraph_computeSuccs(const struct ZoneGraph *zg, struct Zone *z)
+{
+	struct ListIterator *it2;
+	char *printedZone;
+	int sinkZoneReached = 0;
+	/* Image of z by an edge, reused for all the edges */
+	struct Dbmw *dbmtmp = dbmw_new(zg->a->nbClocks);
+
+	printedZone = dbmw_sprint(z->dbm, zg->a->clocks);
+	/* malloc for "s->name, zone" */
+	z->name = malloc(strlen(z->s->name) + strlen(printedZone) + 3);
+	if (z->name == NULL)
+	{
+		perror("malloc zoneGraph_computeSuccs:z->name");
+		exit(EXIT_FAILURE);
+	}
+	sprintf(z->name, "%s, %s", z->s->name, printedZone);
+	free(printedZone);
+
+	for (it2 = listIterator_first(zg->zonesS[z->s->index]) ; 
+			listIterator_hasNext(it2) ; it2 = listIterator_next(it2))
+	{
+		struct Dbmw *ztmp;
+		struct Zone *z2 = listIterator_val(it2);
+		if (z2 == z)
+			continue;
+		ztmp = dbmw_upTo(z->dbm, z2->dbm);
+		if (ztmp != NULL)
+		{
+			z->timeSucc = z2;
+			zone_addEdge(z, z2, TIMELPSD);
+			dbmw_free(ztmp);
+		}
+	}
+	listIterator_release(it2);
+
+	for (it2 = listIterator_first(zg->a->contsTable) ; listIterator_hasNext(it2) 
+			; it2 = listIterator_next(it2))
+	{
+		struct SymbolTableEl *el = listIterator_val(it2);
+		unsigned int k;
+		int found = 0;
+
+		for (k = z->s->contSuccsStart[el->index] ; k < 
+				z->s->contSuccsStart[el->index + 1] ; k++)
+		{
+			struct StateEdge *se = z->s->contSuccs[k];
+			dbmw_copy(dbmtmp, z->dbm);
+			if (dbmw_intersection(dbmtmp, se->dbm))
+			{
+				struct ListIterator *it4;
+				for (it4 = listIterator_first(se->resets) ; 
+						listIterator_hasNext(it4) ; it4 = 
+						listIterator_next(it4))
+				{
+					struct Clock *c = listIterator_val(it4);
+					dbmw_reset(dbmtmp, c);
+				}
+				listIterator_release(it4);
+
+				for (it4 = listIterator_first(zg->zonesS[se->to->index]) ; 
+						listIterator_hasNext(it4) ; it4 = 
+						listIterator_next(it4))
+				{
+					struct Zone *z2 = listIterator_val(it4);
+					if (dbmw_intersects(dbmtmp, z2->dbm))
+					{
+						z->contSuccs[el->index] = z2;
+						list_appendList(z->resetsConts[el->index], se->resets, 
+								NULL);
+						zone_addEdge(z, z2, CONTRCVD);
+						found = 1;
+						break;
+					}
+				}
+				listIterator_release(it4);
+			}
+		}
+
+		if (!found)
+		{
+			z->contSuccs[el->index] = zg->sinkZone;
+			zone_addEdge(z, zg->sinkZone, CONTRCVD);
+			sinkZoneReached = 1;
+		}
+	}
+	listIterator_release(it2);
+
+	for (it2 = listIterator_first(zg->a->uncontsTable) ; 
+			listIterator_hasNext(it2) ; it2 = listIterator_next(it2))
+	{
+		struct SymbolTableEl *el = listIterator_val(it2);
+		unsigned int k;
+		int found = 0;
+
+		for (k = z->s->uncontSuccsStart[el->index] ; k < 
+				z->s->uncontSuccsStart[el->index + 1] ; k++)
+		{
+			struct StateEdge *se = z->s->uncontSuccs[k];
+			dbmw_copy(dbmtmp, z->dbm);
+			if (dbmw_intersection(dbmtmp, se->dbm))
+			{
+				struct ListIterator *it4;
+				for (it4 = listIterator_first(se->resets) ; 
+						listIterator_hasNext(it4) ; it4 = 
+						listIterator_next(it4))
+				{
+					struct Clock *c = listIterator_val(it4);
+					dbmw_reset(dbmtmp, c);
+				}
+				listIterator_release(it4);
+
+				for (it4 = listIterator_first(zg->zonesS[se->to->index]) ; 
+						listIterator_hasNext(it4) ; it4 = 
+						listIterator_next(it4))
+				{
+					struct Zone *z2 = listIterator_val(it4);
+					if (dbmw_intersects(dbmtmp, z2->dbm))
+					{
+						z->uncontSuccs[el->index] = z2;
+						list_appendList(z->resetsUnconts[el->index], 
+								se->resets, NULL);
+						zone_addEdge(z, z2, UNCONTRCVD);
+						found = 1;
+						break;
+					}
+				}
+				listIterator_release(it4);
+			}
+		}
+
+		if (!found)
+		{
+			z->uncontSuccs[el->index] = zg->sinkZone;
+			zone_addEdge(z, zg->sinkZone, UNCONTRCVD);
+			sinkZoneReached = 1;
+		}
+	}
+	listIterator_release(it2);
+	dbmw_free(dbmtmp);
+
+	return sinkZoneReached;
+}
+
+static void zoneGraph_computeSuccsSlice(void *parg, unsigned int begin, 
+		unsigned int end, unsigned int worker)
+{
+	struct ComputeSuccsArg *arg = parg;
+	unsigned int i;
+
+	for (i = begin ; i < end ; i++)
+	{
+		if (zoneGraph_computeSuccs(arg->zg, arg->zones[i]))
+			arg->sinkZoneReached[worker] = 1;
+	}
+}
+
+/**
+ * Updates the refinement r with the partition alpha1 of X, computed by 
+ * zoneGraph_splitZones(X, r->rho): if X is stable, it is added to r->sigma and 
+ * its successors to r->alpha, otherwise X is replaced by alpha1 in r->rho, and 
+ * the predecessors of X become unstable again. alpha1 is freed, and X too if it 
+ * is split.
+ */
+static void zoneGraph_applySplit(struct Refinement *r, struct Zone *X, struct 
+		List *alpha1)
+{
+	struct ListIterator *it;
+	struct Zone *z;
+
+	r->nbIterations++;
+	if (list_size(alpha1) == 1)
+	{
+		struct List *posts;
+
+		if (zoneSet_search(r->sigma, X) == NULL)
+			zoneSet_add(r->sigma, zone_newcp(X));
+
+
+		posts = zoneGraph_post(X, r->rho);
+
+		for (it = listIterator_first(posts) ; listIterator_hasNext(it) ; it 
+				= listIterator_next(it))
+		{
+			z = listIterator_val(it);
+			if (zoneSet_search(r->alpha, z) == NULL)
+				zoneHeap_push(r->unstable, zoneSet_add(r->alpha, 
+							zone_newcp(z)));
+		}
+		listIterator_release(it);
+
+		list_free(posts, (void (*)(void *))zone_free);
+
+		list_free(alpha1, (void (*)(void *))zone_free);
+	}
+	else
+	{
+		struct List *pres;
+
+		r->nbSplits++;
+		zoneSet_remove(r->alpha, X);
+
+		for (it = listIterator_first(alpha1) ; listIterator_hasNext(it) ; it 
+				= listIterator_next(it))
+		{
+			struct Zone *Y = listIterator_val(it);
+			if (Y->s->isInitial && dbmw_containsZero(Y->dbm) &&
+					zoneSet_search(r->alpha, Y) == NULL)
+			{
+				zoneHeap_push(r->unstable, zoneSet_add(r->alpha, 
+							zone_newcp(Y)));
+			}
+		}
+		listIterator_release(it);
+
+		pres = zoneGraph_pre(X, r->rho);
+		for (it = listIterator_first(pres) ; listIterator_hasNext(it) ; it = 
+				listIterator_next(it))
+		{
+			z = listIterator_val(it);
+			struct Zone *z1 = zoneSet_remove(r->sigma, z);
+			if (z1 != NULL)
+			{
+				zoneHeap_push(r->unstable, zoneSet_find(r->alpha, z1));
+				zone_free(z1);
+			}
+		}
+		listIterator_release(it);
+		list_free(pres, (void (*)(void *))zone_free);
+
+		z = zoneSet_remove(r->rho, X);
+		if (z != NULL)
+			zone_free(z);
+		r->dirty[X->s->index] = 1;
+		for (it = listIterator_first(alpha1) ; listIterator_hasNext(it) ; it 
+				= listIterator_next(it))
+		{
+			z = listIterator_val(it);
+			if (zoneSet_search(r->rho, z) == NULL)
+				zoneSet_add(r->rho, zone_newcp(z));
+		}
+		listIterator_release(it);
+		if (r->rho->size > r->peakZones)
+			r->peakZones = r->rho->size;
+		
+		list_free(alpha1, (void (*)(void *))zone_free);
+		zone_free(X);
+	}
+}
+
+static void zoneGraph_splitZonesSlice(void *parg, unsigned int begin, unsigned 
+		int end, unsigned int worker)
+{
+	struct SplitZonesArg *arg = parg;
+	unsigned int i;
+
+	(void)worker;
+	for (i = begin ; i < end ; i++)
+		arg->splits[i] = zoneGraph_splitZones(arg->batch[i], arg->r->rho);
+}
+
+/**
+ * Returns 1 if the split of X may have changed since the zones of the states 
+ * marked in r->dirty changed in r->rho.
+ */
+static int zoneGraph_isSplitStale(const struct Refinement *r, const struct Zone 
+		*X)
+{
+	unsigned int i;
+
+	if (r->dirty[X->s->index])
+		return 1;
+	for (i = 0 ; i < X->s->nbSuccStates ; i++)
+	{
+		if (r->dirty[X->s->succStates[i]->index])
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Parallel version of the refinement loop: at each round, the oldest unstable 
+ * zones are split concurrently, against the same r->rho. The zones are then 
+ * taken in the same order as in the sequential loop, i.e. the oldest unstable 
+ * one first, so that the result does not depend on the number of threads. The 
+ * split of a zone of the round is used unless it may have been invalidated by 
+ * the ones applied before it, in which case it is computed again. A zone made 
+ * unstable again by a split may come before the next zone of the round: it is 
+ * then split at once.
+ */
+static void zoneGraph_refineParallel(struct Refinement *r, struct ThreadPool 
+		*pool)
+{
+	struct SplitZonesArg arg;
+	unsigned int i, n, batchSize;
+	struct Zone *X;
+
+	batchSize = threadPool_nbThreads(pool) * REFINE_BATCHPERTHREAD;
+	arg.r = r;
+	arg.batch = malloc(batchSize * sizeof *(arg.batch));
+	arg.splits = malloc(batchSize * sizeof *(arg.splits));
+	if (arg.batch == NULL || arg.splits == NULL)
+	{
+		perror("malloc zoneGraph_refineParallel:arg.batch");
+		exit(EXIT_FAILURE);
+	}
+
+	while ((X = zoneHeap_top(r->unstable)) != NULL)
+	{
+		/* The zones of the round stay in the heap, which keeps their order */
+		for (n = 0 ; n < batchSize && (X = zoneHeap_top(r->unstable)) != NULL 
+				; n++)
+		{
+			zoneHeap_remove(r->unstable, zoneSet_find(r->alpha, X));
+			arg.batch[n] = X;
+		}
+		for (i = 0 ; i < n ; i++)
+			zoneHeap_push(r->unstable, zoneSet_find(r->alpha, arg.batch[i]));
+
+		threadPool_run(pool, n, zoneGraph_splitZonesSlice, &arg);
+
+		for (i = 0 ; i < r->nbStates ; i++)
+			r->dirty[i] = 0;
+		i = 0;
+		while (i < n)
+		{
+			X = zoneHeap_top(r->unstable);
+			zoneHeap_remove(r->unstable, zoneSet_find(r->alpha, X));
+			if (X != arg.batch[i])
+			{
+				zoneGraph_applySplit(r, X, zoneGraph_splitZones(X, r->rho));
+				continue;
+			}
+			if (zoneGraph_isSplitStale(r, X))
+			{
+				list_free(arg.splits[i], (void (*)(void *))zone_free);
+				arg.splits[i] = zoneGraph_splitZones(X, r->rho);
+			}
+			zoneGraph_applySplit(r, X, arg.splits[i]);
+			i++;
+		}
+	}
+
+	free(arg.batch);
+	free(arg.splits);
+}
+
+/**
+ * Adds to r the zones of old whose state is mapped by oldStates (see 
+ * timedAutomaton_diff) to a state of zg->a: they are added to rho, and the ones 
+ * reachable from old->z0 to alpha. These are stable, and added to sigma, unless 
+ * their state is marked in unstable: they are then split again against the new 
+ * zones of its successors. The other states get one zone each, which is 
+ * unstable if the state is initial.
+ */
+static void zoneGraph_seedFromOld(struct Refinement *r, const struct ZoneGraph 
+		*zg, const struct ZoneGraph *old, const struct State **oldStates, const 
+		int *unstable)
+{
+	const struct TimedAutomaton *a = zg->a;
+	const struct State **newStates;
+	const struct Zone **stack;
+	struct ListIterator *it;
+	char *reached;
+	unsigned int i, n;
+	struct Zone *z;
+
+	newStates = calloc(old->a->nbStates + 1, sizeof *newStates);
+	reached = calloc(old->nbZones, sizeof *reached);
+	stack = malloc(old->nbZones * sizeof *stack);
+	if (newStates == NULL || reached == NULL || stack == NULL)
+	{
+		perror("malloc zoneGraph_seedFromOld:newStates");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0 ; i < a->nbStates ; i++)
+	{
+		if (oldStates[i] != NULL)
+			newStates[oldStates[i]->index] = &(a->states[i]);
+	}
+
+	n = 0;
+	reached[old->z0->index] = 1;
+	stack[n++] = old->z0;
+	while (n > 0)
+	{
+		const struct Zone *z1 = stack[--n];
+		for (it = listIterator_first(z1->edges) ; listIterator_hasNext(it) ; 
+				it = listIterator_next(it))
+		{
+			const struct ZoneEdge *e = listIterator_val(it);
+			if (!reached[e->succ->index])
+			{
+				reached[e->succ->index] = 1;
+				stack[n++] = e->succ;
+			}
+		}
+		listIterator_release(it);
+	}
+
+	for (it = listIterator_first(old->zones) ; listIterator_hasNext(it) ; it = 
+			listIterator_next(it))
 	{
-		perror("realloc stringArray_newNext:ret->s");
-		exit(EXIT_FAILURE);
+		const struct Zone *oldz = listIterator_val(it);
+		const struct State *s = newStates[oldz->s->index];
+		if (oldz == old->sinkZone || s == NULL)
+			continue;
+		z = zone_new(s, dbmw_newcp(oldz->dbm), zg);
+		zoneSet_add(r->rho, z);
+		if (!reached[oldz->index])
+			continue;
+		if (unstable[s->index])
+			zoneHeap_push(r->unstable, zoneSet_add(r->alpha, zone_newcp(z)));
+		else
+		{
+			zoneSet_add(r->alpha, zone_newcp(z));
+			zoneSet_add(r->sigma, zone_newcp(z));
+		}
 	}
+	listIterator_release(it);
 
-	ret->s[strlen(ret->s) + 1] = '\0';
-	ret->s[strlen(ret->s)] = c;
-
-	for (i = 0 ; i < g->zoneGraph->nbZones ; i++)
+	for (i = 0 ; i < a->nbStates ; i++)
 	{
-		const struct Zone *last = ret->lasts[i];
-		const struct Zone *next = zone_nextCont(last, c);
-		ret->array->tab[i][next->index] = 1;
-		ret->lasts[i] = next;
+		if (oldStates[i] != NULL)
+			continue;
+		z = zone_new(&(a->states[i]), dbmw_new(a->nbClocks), zg);
+		zoneSet_add(r->rho, z);
+		if (a->states[i].isInitial)
+			zoneHeap_push(r->unstable, zoneSet_add(r->alpha, zone_newcp(z)));
 	}
 
-	return ret;
-}
-
-static void stringArray_free(struct StringArray *sa)
-{
-	free(sa->s);
-	arraytwo_free(sa->array);
-	free(sa->lasts);
-	free(sa);
+	free(newStates);
+	free(reached);
+	free(stack);
 }
 
-
-/* ZoneGraph */
-/* ZoneGraph private interface */
-static struct ZoneGraph *zoneGraph_new(const struct TimedAutomaton *a)
+/**
+ * The successors of the zones are computed on the threads of pool, and so is 
+ * the refinement if opts->parallelRefinement is set.
+ * If old is not NULL, the refinement starts from its zones for the states that 
+ * oldStates maps to a state of old (see timedAutomaton_diff), so that only the 
+ * other states are refined from scratch, and the zones of the states marked in 
+ * unstable are split again.
+ * The refinement and the computation of the successors are recorded in stats.
+ */
+static struct ZoneGraph *zoneGraph_new(const struct TimedAutomaton *a, const 
+		struct ZoneGraph *old, const struct State **oldStates, const int 
+		*unstable, const struct GraphOptions *opts, struct ThreadPool *pool, 
+		struct GraphStats *stats)
 {
-	struct List *rho = list_new();
-	struct List *alpha = list_new();
-	struct List *sigma = list_new();
-	struct List *alpha1;
+	struct PhaseTimer timer;
+	struct Refinement r;
 	struct ListIterator *it;
+	struct ZoneSetEntry *e;
 	struct Zone *X, *z;
+	struct Zone **zones;
+	struct ComputeSuccsArg arg;
 	int i;
 	struct ZoneGraph *zg;
 	int sinkZoneReached;
 
+	graphStats_startPhase(&timer, pool);
+
 	zg = malloc(sizeof *zg);
 	if (zg == NULL)
 	{
@@ -2219,287 +3972,113 @@ static struct ZoneGraph *zoneGraph_new(const struct TimedAutomaton *a)
 		zg->zonesS[i] = list_new();
 	}
 	zg->z0 = NULL;
+	zg->dbms = dbmwTable_new();
 	zg->sinkZone = zone_new(a->sinkBadState, dbmw_new(a->nbClocks), zg);
 
-	X = NULL;
-	for (i = 0 ; i < a->nbStates ; i++)
+	r.nbStates = a->nbStates + 1;
+	r.rho = zoneSet_new(r.nbStates);
+	r.alpha = zoneSet_new(r.nbStates);
+	r.sigma = zoneSet_new(r.nbStates);
+	r.unstable = zoneHeap_new();
+	r.dirty = calloc(r.nbStates, sizeof *(r.dirty));
+	if (r.dirty == NULL)
 	{
-		z = zone_new(&(a->states[i]), dbmw_new(a->nbClocks), zg);
-		list_append(rho, z);
-		if (a->states[i].isInitial)
-		{
-			struct Zone *z2 = zone_newcp(z);
-			list_append(alpha, z2);
-			X = z2;
-		}
+		perror("calloc zoneGraph_new:r.dirty");
+		exit(EXIT_FAILURE);
 	}
+	r.nbIterations = 0;
+	r.nbSplits = 0;
 
-	while (X != NULL)
+	X = NULL;
+	if (old != NULL)
 	{
-		alpha1 = zoneGraph_splitZones(X, rho);
-
-		if (list_size(alpha1) == 1)
+		zoneGraph_seedFromOld(&r, zg, old, oldStates, unstable);
+		X = zoneHeap_top(r.unstable);
+	}
+	else
+	{
+		for (i = 0 ; i < a->nbStates ; i++)
 		{
-			struct List *posts;
-
-			if (list_search(sigma, X, (int (*)(const void *, const void 
-								*))zone_areEqual) == NULL)
-				list_append(sigma, zone_newcp(X));
-
-
-			posts = zoneGraph_post(X, rho);
-
-			for (it = listIterator_first(posts) ; listIterator_hasNext(it) ; it 
-					= listIterator_next(it))
+			z = zone_new(&(a->states[i]), dbmw_new(a->nbClocks), zg);
+			zoneSet_add(r.rho, z);
+			if (a->states[i].isInitial)
 			{
-				z = listIterator_val(it);
-				if (list_search(alpha, z, (int (*)(const void *, const void 
-									*))zone_areEqual) == NULL)
-					list_append(alpha, zone_newcp(z));
+				struct Zone *z2 = zone_newcp(z);
+				zoneHeap_push(r.unstable, zoneSet_add(r.alpha, z2));
+				X = z2;
 			}
-			listIterator_release(it);
-
-			list_free(posts, (void (*)(void *))zone_free);
-
-			list_free(alpha1, (void (*)(void *))zone_free);
 		}
-		else
-		{
-			struct List *pres;
-
-			list_remove(alpha, X);
-
-			for (it = listIterator_first(alpha1) ; listIterator_hasNext(it) ; it 
-					= listIterator_next(it))
-			{
-				struct Zone *Y = listIterator_val(it);
-				if (Y->s->isInitial && dbmw_containsZero(Y->dbm) &&
-						list_search(alpha, Y, (int (*)(const void *, const void 
-									*))zone_areEqual) == NULL)
-				{
-					list_append(alpha, zone_newcp(Y));
-				}
-			}
-			listIterator_release(it);
-
-			pres = zoneGraph_pre(X, rho);
-			for (it = listIterator_first(pres) ; listIterator_hasNext(it) ; it = 
-					listIterator_next(it))
-			{
-				z = listIterator_val(it);
-				struct Zone *z1 = list_search(sigma, z, (int (*)(const void *, 
-								const void *))zone_areEqual);
-				if (z1 != NULL)
-				{
-					list_remove(sigma, z1);
-					zone_free(z1);
-				}
-			}
-			listIterator_release(it);
-			list_free(pres, (void (*)(void *))zone_free);
+	}
 
-			z = list_search(rho, X, (int (*)(const void *, const void 
-							*))zone_areEqual);
-			if (z != NULL)
-			{
-				list_remove(rho, z);
-				zone_free(z);
-			}
-			for (it = listIterator_first(alpha1) ; listIterator_hasNext(it) ; it 
-					= listIterator_next(it))
-			{
-				z = listIterator_val(it);
-				if (list_search(rho, z, (int (*)(const void *, const void 
-									*))zone_areEqual) == NULL)
-					list_append(rho, zone_newcp(z));
-			}
-			listIterator_release(it);
-			
-			list_free(alpha1, (void (*)(void *))zone_free);
-			zone_free(X);
-		}
+	r.peakZones = r.rho->size;
 
-		X = NULL;
-		for (it = listIterator_first(alpha) ; listIterator_hasNext(it) ; it = 
-				listIterator_next(it))
+	if (opts->parallelRefinement && threadPool_nbThreads(pool) > 1)
+		zoneGraph_refineParallel(&r, pool);
+	else
+	{
+		while (X != NULL)
 		{
-			z = listIterator_val(it);
-			if (list_search(sigma, z,
-				(int (*)(const void *, const void *))zone_areEqual) ==
-					NULL)
-			{
-				X = z;
-				break;
-			}
+			zoneHeap_remove(r.unstable, zoneSet_find(r.alpha, X));
+			zoneGraph_applySplit(&r, X, zoneGraph_splitZones(X, r.rho));
+			X = zoneHeap_top(r.unstable);
 		}
-		listIterator_release(it);
 	}
+	zoneHeap_free(r.unstable);
+	free(r.dirty);
+	stats->nbRefineIterations = r.nbIterations;
+	stats->nbSplits = r.nbSplits;
+	stats->peakZones = r.peakZones;
+	graphStats_endPhase(stats, GRAPHPHASE_REFINEMENT, &timer, pool);
 
-	for (it = listIterator_first(rho) ; listIterator_hasNext(it) ; it = 
-			listIterator_next(it))
+	graphStats_startPhase(&timer, pool);
+	for (e = r.rho->first ; e != NULL ; e = e->next)
 	{
-		z = listIterator_val(it);
+		z = e->z;
 		list_append(zg->zones, z);
 		list_append(zg->zonesS[z->s->index], z);
 	}
-	listIterator_release(it);
 
 	list_append(zg->zones, zg->sinkZone);
 	zg->zonesS[a->sinkBadState->index] = list_new();
 	list_append(zg->zonesS[a->sinkBadState->index], zg->sinkZone);
 
-	sinkZoneReached = 0;
-
+	zones = malloc(list_size(zg->zones) * sizeof *zones);
+	if (zones == NULL)
+	{
+		perror("malloc zoneGraph_new:zones");
+		exit(EXIT_FAILURE);
+	}
 	for (it = listIterator_first(zg->zones), i = 0 ; listIterator_hasNext(it) ; 
 			it = listIterator_next(it), i++)
 	{
-		struct ListIterator *it2;
-		char *printedZone;
-
 		z = listIterator_val(it);
 		z->index = i;
-
-		printedZone = dbmw_sprint(z->dbm, a->clocks);
-		/* malloc for "s->name, zone" */
-		z->name = malloc(strlen(z->s->name) + strlen(printedZone) + 3);
-		if (z->name == NULL)
-		{
-			perror("malloc zoneGraph_new:z->name");
-			exit(EXIT_FAILURE);
-		}
-		sprintf(z->name, "%s, %s", z->s->name, printedZone);
-		free(printedZone);
-
+		zones[i] = z;
 		if (z->s->isInitial && dbmw_containsZero(z->dbm))
 			zg->z0 = z;
+	}
+	listIterator_release(it);
 
-		for (it2 = listIterator_first(zg->zonesS[z->s->index]) ; 
-				listIterator_hasNext(it2) ; it2 = listIterator_next(it2))
-		{
-			struct Dbmw *ztmp;
-			struct Zone *z2 = listIterator_val(it2);
-			if (z2 == z)
-				continue;
-			ztmp = dbmw_upTo(z->dbm, z2->dbm);
-			if (ztmp != NULL)
-			{
-				z->timeSucc = z2;
-				zone_addEdge(z, z2, TIMELPSD);
-				dbmw_free(ztmp);
-			}
-		}
-		listIterator_release(it2);
-
-		for (it2 = listIterator_first(a->contsTable) ; listIterator_hasNext(it2) 
-				; it2 = listIterator_next(it2))
-		{
-			struct SymbolTableEl *el = listIterator_val(it2);
-			struct ListIterator *it3;
-			int found = 0;
-
-			for (it3 = listIterator_first(z->s->contSuccs[(unsigned char)el->c]) 
-					; listIterator_hasNext(it3) ; it3 = listIterator_next(it3))
-			{
-				struct StateEdge *se = listIterator_val(it3);
-				struct Dbmw *dbmtmp = dbmw_newcp(z->dbm);
-				if (dbmw_intersection(dbmtmp, se->dbm))
-				{
-					struct ListIterator *it4;
-					for (it4 = listIterator_first(se->resets) ; 
-							listIterator_hasNext(it4) ; it4 = 
-							listIterator_next(it4))
-					{
-						struct Clock *c = listIterator_val(it4);
-						dbmw_reset(dbmtmp, c);
-					}
-					listIterator_release(it4);
-
-					for (it4 = listIterator_first(zg->zonesS[se->to->index]) ; 
-							listIterator_hasNext(it4) ; it4 = 
-							listIterator_next(it4))
-					{
-						struct Zone *z2 = listIterator_val(it4);
-						if (dbmw_intersects(dbmtmp, z2->dbm))
-						{
-							z->contSuccs[el->index] = z2;
-							list_appendList(z->resetsConts[el->index], se->resets, 
-									NULL);
-							zone_addEdge(z, z2, CONTRCVD);
-							found = 1;
-							break;
-						}
-					}
-					listIterator_release(it4);
-				}
-				dbmw_free(dbmtmp);
-			}
-			listIterator_release(it3);
-
-			if (!found)
-			{
-				z->contSuccs[el->index] = zg->sinkZone;
-				zone_addEdge(z, zg->sinkZone, CONTRCVD);
-				sinkZoneReached = 1;
-			}
-		}
-		listIterator_release(it2);
-
-		for (it2 = listIterator_first(a->uncontsTable) ; 
-				listIterator_hasNext(it2) ; it2 = listIterator_next(it2))
-		{
-			struct SymbolTableEl *el = listIterator_val(it2);
-			struct ListIterator *it3;
-			int found = 0;
-
-			for (it3 = listIterator_first(z->s->uncontSuccs[(unsigned 
-							char)el->c]) ; listIterator_hasNext(it3) ; it3 = 
-					listIterator_next(it3))
-			{
-				struct StateEdge *se = listIterator_val(it3);
-				struct Dbmw *dbmtmp = dbmw_newcp(z->dbm);
-				if (dbmw_intersection(dbmtmp, se->dbm))
-				{
-					struct ListIterator *it4;
-					for (it4 = listIterator_first(se->resets) ; 
-							listIterator_hasNext(it4) ; it4 = 
-							listIterator_next(it4))
-					{
-						struct Clock *c = listIterator_val(it4);
-						dbmw_reset(dbmtmp, c);
-					}
-					listIterator_release(it4);
-
-					for (it4 = listIterator_first(zg->zonesS[se->to->index]) ; 
-							listIterator_hasNext(it4) ; it4 = 
-							listIterator_next(it4))
-					{
-						struct Zone *z2 = listIterator_val(it4);
-						if (dbmw_intersects(dbmtmp, z2->dbm))
-						{
-							z->uncontSuccs[el->index] = z2;
-							list_appendList(z->resetsUnconts[el->index], 
-									se->resets, NULL);
-							zone_addEdge(z, z2, UNCONTRCVD);
-							found = 1;
-							break;
-						}
-					}
-					listIterator_release(it4);
-				}
-				dbmw_free(dbmtmp);
-			}
-			listIterator_release(it3);
+	arg.zg = zg;
+	arg.zones = zones;
+	arg.sinkZoneReached = calloc(threadPool_nbThreads(pool), sizeof 
+			*(arg.sinkZoneReached));
+	if (arg.sinkZoneReached == NULL)
+	{
+		perror("calloc zoneGraph_new:arg.sinkZoneReached");
+		exit(EXIT_FAILURE);
+	}
+	threadPool_run(pool, list_size(zg->zones), zoneGraph_computeSuccsSlice, 
+			&arg);
 
-			if (!found)
-			{
-				z->uncontSuccs[el->index] = zg->sinkZone;
-				zone_addEdge(z, zg->sinkZone, UNCONTRCVD);
-				sinkZoneReached = 1;
-			}
-		}
-		listIterator_release(it2);
+	sinkZoneReached = 0;
+	for (i = 0 ; i < threadPool_nbThreads(pool) ; i++)
+	{
+		if (arg.sinkZoneReached[i])
+			sinkZoneReached = 1;
 	}
-	listIterator_release(it);
+	free(arg.sinkZoneReached);
+	free(zones);
 
 	if (!sinkZoneReached)
 	{
@@ -2512,163 +4091,179 @@ static struct ZoneGraph *zoneGraph_new(const struct TimedAutomaton *a)
 
 
 	zg->nbZones = list_size(zg->zones);
+	stats->nbDbms = dbmwTable_size(zg->dbms);
+	zoneGraph_computeTimeChains(zg);
 
-	list_free(rho, NULL);
-	list_free(alpha, (void (*)(void *))zone_free);
-	list_free(sigma, (void (*)(void *))zone_free);
+	zoneSet_free(r.rho, NULL);
+	zoneSet_free(r.alpha, zone_free);
+	zoneSet_free(r.sigma, zone_free);
+	graph_releaseDbmwPools(pool);
+	graphStats_endPhase(stats, GRAPHPHASE_ZONESUCCS, &timer, pool);
 
 	return zg;
 }
 
-/*
- * returns a list of DBMs, not of zones
+/**
+ * Computes the timeChain of every zone of zg, so that the zone reached by 
+ * letting time elapse from a valuation is found with a single call to 
+ * dbmw_firstIncluding.
  */
-static struct List *zoneGraph_splitZones2(const struct Zone *z0, const struct 
-		Zone *z1)
+static void zoneGraph_computeTimeChains(struct ZoneGraph *zg)
 {
-	struct List *ret;
-	struct List *dbms = list_new();
-	int i;
 	struct ListIterator *it;
 
-	list_append(dbms, dbmw_newcp(z0->dbm));
-	for (i = 0 ; i < 256 ; i++)
+	for (it = listIterator_first(zg->zones) ; listIterator_hasNext(it) ; it = 
+			listIterator_next(it))
 	{
-		if (z0->s->contSuccs[i] != NULL)
-		{
-			for (it = listIterator_first(z0->s->contSuccs[i]) ; 
-					listIterator_hasNext(it) ; it = listIterator_next(it))
-			{
-				struct StateEdge *se = listIterator_val(it);
-				if (se->to == z1->s)
-				{
-					struct Dbmw *ztmp = dbmw_newcp(z1->dbm);
-					struct Dbmw *z;
-					struct ListIterator *it2;
+		struct Zone *z = listIterator_val(it);
+		const struct Zone *z2;
+		unsigned int n = 0;
 
-					for (it2 = listIterator_first(se->resets) ; 
-							listIterator_hasNext(it2) ; it2 = 
-							listIterator_next(it2))
-					{
-						struct Clock *c = listIterator_val(it2);
-						dbmw_freeClock(ztmp, c);
-					}
-					listIterator_release(it2);
+		/* The time successors are strictly later, but do not trust a loaded 
+		 * graph */
+		for (z2 = z ; z2 != NULL && n < zg->nbZones ; z2 = z2->timeSucc)
+			n++;
 
-					if (dbmw_intersection(ztmp, se->dbm) &&
-							dbmw_intersection(ztmp, z0->dbm))
-					{
-						z = dbmw_upTo(z0->dbm, ztmp);
-						if (z != NULL)
-							list_append(dbms, z);
-					}
-					dbmw_free(ztmp);
-				}
-			}
-			listIterator_release(it);
-		}
-		if (z0->s->uncontSuccs[i] != NULL)
+		z->timeChain = malloc(n * sizeof *(z->timeChain));
+		if (z->timeChain == NULL)
 		{
-			for (it = listIterator_first(z0->s->uncontSuccs[i]) ; 
-					listIterator_hasNext(it) ; it = listIterator_next(it))
-			{
-				struct StateEdge *se = listIterator_val(it);
-				if (se->to == z1->s)
-				{
-					struct Dbmw *ztmp = dbmw_newcp(z1->dbm);
-					struct Dbmw *z;
-					struct ListIterator *it2;
+			perror("malloc zoneGraph_computeTimeChains:z->timeChain");
+			exit(EXIT_FAILURE);
+		}
+		z->timeChainLength = n;
+		for (z2 = z, n = 0 ; n < z->timeChainLength ; z2 = z2->timeSucc, n++)
+			z->timeChain[n] = z2->dbm;
+	}
+	listIterator_release(it);
+}
 
-					for (it2 = listIterator_first(se->resets) ; 
-							listIterator_hasNext(it2) ; it2 = 
-							listIterator_next(it2))
-					{
-						struct Clock *c = listIterator_val(it2);
-						dbmw_freeClock(ztmp, c);
-					}
-					listIterator_release(it2);
+/*
+ * Appends to out the partition of z0 induced by z1. ztmp is a temporary DBM of 
+ * the dimension of z0.
+ */
+static void zoneGraph_splitZones2(const struct Zone *z0, const struct Zone *z1, 
+		struct Dbmw *ztmp, struct Fed *out)
+{
+	struct Fed *dbms = fed_new(z0->zg->a->nbClocks);
+	struct Dbmw *z = dbmw_new(z0->zg->a->nbClocks);
+	int i;
 
-					if (dbmw_intersection(ztmp, se->dbm) &&
-							dbmw_intersection(ztmp, z0->dbm))
-					{
-						z = dbmw_upTo(z0->dbm, ztmp);
-						if (z != NULL)
-							list_append(dbms, z);
-					}
-					dbmw_free(ztmp);
-				}
+	fed_append(dbms, z0->dbm);
+	for (i = 0 ; i < z0->s->nbOutEdges ; i++)
+	{
+		const struct StateEdge *se = z0->s->outEdges[i];
+		if (se->to == z1->s)
+		{
+			struct ListIterator *it;
+
+			dbmw_copy(ztmp, z1->dbm);
+			for (it = listIterator_first(se->resets) ; listIterator_hasNext(it) 
+					; it = listIterator_next(it))
+			{
+				struct Clock *c = listIterator_val(it);
+				dbmw_freeClock(ztmp, c);
 			}
 			listIterator_release(it);
+
+			if (dbmw_intersection(ztmp, se->dbm) &&
+					dbmw_intersection(ztmp, z0->dbm) &&
+					dbmw_upToInto(z, z0->dbm, ztmp))
+			{
+				fed_append(dbms, z);
+			}
 		}
 	}
 
-	if (z0->s == z1->s)
+	if (z0->s == z1->s && dbmw_upToInto(z, z0->dbm, z1->dbm))
 	{
-		struct Dbmw *z = dbmw_upTo(z0->dbm, z1->dbm);
-		if (z != NULL)
-			list_append(dbms, z);
+		fed_append(dbms, z);
 	}
 
-	ret = dbmw_partition(dbms);
-	list_free(dbms, (void (*)(void *))dbmw_free);
+	fed_partition(dbms);
+	fed_union(out, dbms);
 
-	return ret;
+	dbmw_free(z);
+	fed_free(dbms);
 }
 
-static struct List *zoneGraph_splitZones(const struct Zone *z, const struct List 
-		*rho)
+/**
+ * Only the zones of rho whose state is z->s or a successor of z->s can split z, 
+ * the other ones would only contribute z itself to the partition.
+ * The pieces of the partition that are included in the same zones of the split 
+ * are merged when their union is convex, since there is no need to tell them 
+ * apart.
+ */
+static struct List *zoneGraph_splitZones(const struct Zone *z, const struct 
+		ZoneSet *rho)
 {
-	struct ListIterator *it;
-	struct List *splits = list_new();
-	struct List *partition;
+	struct Fed *splits = fed_new(z->zg->a->nbClocks);
+	struct Fed *classes = fed_new(z->zg->a->nbClocks);
+	struct Dbmw *ztmp = dbmw_new(z->zg->a->nbClocks);
 	struct List *ret = list_new();
+	struct Zone **zones;
+	unsigned int i, n;
 
-	for (it = listIterator_first(rho) ; listIterator_hasNext(it) ; it = 
-			listIterator_next(it))
-	{
-		struct Zone *z1 = listIterator_val(it);
-		struct ListIterator *it2;
-		struct List *part = zoneGraph_splitZones2(z, z1);
+	fed_append(splits, z->dbm);
 
-		for (it2 = listIterator_first(part) ; listIterator_hasNext(it2) ; it2 = 
-				listIterator_next(it2))
-		{
-			struct Dbmw *z2 = listIterator_val(it2);
-			list_append(splits, z2);
-		}
-		listIterator_release(it2);
+	zones = zoneSet_neighbours(rho, z->s, z->s->succStates, 
+			z->s->nbSuccStates, &n);
+	for (i = 0 ; i < n ; i++)
+		zoneGraph_splitZones2(z, zones[i], ztmp, splits);
+	free(zones);
+	dbmw_free(ztmp);
 
-		list_free(part, NULL);
-	}
-	listIterator_release(it);
+	fed_union(classes, splits);
+	fed_partition(splits);
+	fed_mergeAdjacent(splits, classes);
+
+	for (i = 0 ; i < fed_size(splits) ; i++)
+		list_append(ret, zone_new(z->s, fed_getDbmw(splits, i), z->zg));
+
+	fed_free(splits);
+	fed_free(classes);
 
-	partition = dbmw_partition(splits);
+	return ret;
+}
 
-	list_free(splits, (void (*)(void *))dbmw_free);
+/**
+ * Returns 1 if some valuation of z0 reaches z1 through the edge se.
+ */
+static int zoneGraph_edgeReaches(const struct Zone *z0, const struct StateEdge 
+		*se, const struct Zone *z1)
+{
+	struct Dbmw *ztmp = dbmw_newcp(z0->dbm);
+	struct ListIterator *it;
+	int ret;
 
-	for (it = listIterator_first(partition) ; listIterator_hasNext(it) ; it = 
+	dbmw_intersection(ztmp, se->dbm);
+	for (it = listIterator_first(se->resets) ; listIterator_hasNext(it) ; it = 
 			listIterator_next(it))
 	{
-		struct Dbmw *dbm = listIterator_val(it);
-		list_append(ret, zone_new(z->s, dbm, z->zg));
+		struct Clock *c = listIterator_val(it);
+		dbmw_reset(ztmp, c);
 	}
 	listIterator_release(it);
 
-	list_free(partition, NULL);
+	dbmw_intersection(ztmp, z1->dbm);
+	ret = !dbmw_isEmpty(ztmp);
+	dbmw_free(ztmp);
 
 	return ret;
 }
 
-static struct List *zoneGraph_pre(const struct Zone *z, const struct List *rho)
+static struct List *zoneGraph_pre(const struct Zone *z, const struct ZoneSet 
+		*rho)
 {
-	int i;
-	struct ListIterator *it;
+	int j;
+	unsigned int i, n;
+	struct Zone **zones;
 	struct List *ret = list_new();
 
-	for (it = listIterator_first(rho) ; listIterator_hasNext(it) ; it = 
-			listIterator_next(it))
+	zones = zoneSet_neighbours(rho, z->s, z->s->predStates, 
+			z->s->nbPredStates, &n);
+	for (i = 0 ; i < n ; i++)
 	{
-		struct Zone *z2 = listIterator_val(it);
+		struct Zone *z2 = zones[i];
 		if (z2->s == z->s)
 		{
 			struct Dbmw *dbm = dbmw_upTo(z2->dbm, z->dbm);
@@ -2678,88 +4273,32 @@ static struct List *zoneGraph_pre(const struct Zone *z, const struct List *rho)
 				dbmw_free(dbm);
 			}
 		}
-		
-		for (i = 0 ; i < 256 ; i++)
+
+		for (j = 0 ; j < z2->s->nbOutEdges ; j++)
 		{
-			if (z2->s->contSuccs[i] != NULL)
-			{
-				struct ListIterator *it2;
-				for (it2 = listIterator_first(z2->s->contSuccs[i]) ; 
-						listIterator_hasNext(it2) ; it2 = 
-						listIterator_next(it2))
-				{
-					struct StateEdge *se = listIterator_val(it2);
-					if (se->to == z->s)
-					{
-						struct Dbmw *ztmp = dbmw_newcp(z2->dbm);
-						struct ListIterator *it2;
-
-						dbmw_intersection(ztmp, se->dbm);
-						for (it2 = listIterator_first(se->resets) ; 
-								listIterator_hasNext(it2) ; it2 = 
-								listIterator_next(it2))
-						{
-							struct Clock *c = listIterator_val(it2);
-							dbmw_reset(ztmp, c);
-						}
-						listIterator_release(it2);
-
-						dbmw_intersection(ztmp, z->dbm);
-						if (!dbmw_isEmpty(ztmp))
-							list_append(ret, zone_newcp(z2));
-						dbmw_free(ztmp);
-					}
-				}
-				listIterator_release(it2);
-			}
-			if (z2->s->uncontSuccs[i] != NULL)
-			{
-				struct ListIterator *it2;
-				for (it2 = listIterator_first(z2->s->uncontSuccs[i]) ; 
-						listIterator_hasNext(it2) ; it2 = 
-						listIterator_next(it2))
-				{
-					struct StateEdge *se = listIterator_val(it2);
-					if (se->to == z->s)
-					{
-						struct Dbmw *ztmp = dbmw_newcp(z2->dbm);
-						struct ListIterator *it2;
-
-						dbmw_intersection(ztmp, se->dbm);
-						for (it2 = listIterator_first(se->resets) ; 
-								listIterator_hasNext(it2) ; it2 = 
-								listIterator_next(it2))
-						{
-							struct Clock *c = listIterator_val(it2);
-							dbmw_reset(ztmp, c);
-						}
-						listIterator_release(it2);
-
-						dbmw_intersection(ztmp, z->dbm);
-						if (!dbmw_isEmpty(ztmp))
-							list_append(ret, zone_newcp(z2));
-						dbmw_free(ztmp);
-					}
-				}
-				listIterator_release(it2);
-			}
+			const struct StateEdge *se = z2->s->outEdges[j];
+			if (se->to == z->s && zoneGraph_edgeReaches(z2, se, z))
+				list_append(ret, zone_newcp(z2));
 		}
 	}
-	listIterator_release(it);
+	free(zones);
 
 	return ret;
 }
 
-static struct List *zoneGraph_post(const struct Zone *z, struct List *rho)
+static struct List *zoneGraph_post(const struct Zone *z, const struct ZoneSet 
+		*rho)
 {
-	int i;
-	struct ListIterator *it;
+	int j;
+	unsigned int i, n;
+	struct Zone **zones;
 	struct List *ret = list_new();
 
-	for (it = listIterator_first(rho) ; listIterator_hasNext(it) ; it = 
-			listIterator_next(it))
+	zones = zoneSet_neighbours(rho, z->s, z->s->succStates, 
+			z->s->nbSuccStates, &n);
+	for (i = 0 ; i < n ; i++)
 	{
-		struct Zone *z2 = listIterator_val(it);
+		struct Zone *z2 = zones[i];
 		if (z2->s == z->s)
 		{
 			struct Dbmw *dbm = dbmw_upTo(z->dbm, z2->dbm);
@@ -2769,74 +4308,15 @@ static struct List *zoneGraph_post(const struct Zone *z, struct List *rho)
 				dbmw_free(dbm);
 			}
 		}
-		
-		for (i = 0 ; i < 256 ; i++)
+
+		for (j = 0 ; j < z->s->nbOutEdges ; j++)
 		{
-			if (z->s->contSuccs[i] != NULL)
-			{
-				struct ListIterator *it2;
-				for (it2 = listIterator_first(z->s->contSuccs[i]) ; 
-						listIterator_hasNext(it2) ; it2 = 
-						listIterator_next(it2))
-				{
-					struct StateEdge *se = listIterator_val(it2);
-					if (se->to == z2->s)
-					{
-						struct Dbmw *ztmp = dbmw_newcp(z->dbm);
-						struct ListIterator *it2;
-
-						dbmw_intersection(ztmp, se->dbm);
-						for (it2 = listIterator_first(se->resets) ; 
-								listIterator_hasNext(it2) ; it2 = 
-								listIterator_next(it2))
-						{
-							struct Clock *c = listIterator_val(it2);
-							dbmw_reset(ztmp, c);
-						}
-						listIterator_release(it2);
-
-						dbmw_intersection(ztmp, z2->dbm);
-						if (!dbmw_isEmpty(ztmp))
-							list_append(ret, zone_newcp(z2));
-						dbmw_free(ztmp);
-					}
-				}
-				listIterator_release(it2);
-			}
-			if (z->s->uncontSuccs[i] != NULL)
-			{
-				struct ListIterator *it2;
-				for (it2 = listIterator_first(z->s->uncontSuccs[i]) ; 
-						listIterator_hasNext(it2) ; it2 = 
-						listIterator_next(it2))
-				{
-					struct StateEdge *se = listIterator_val(it2);
-					if (se->to == z2->s)
-					{
-						struct Dbmw *ztmp = dbmw_newcp(z->dbm);
-						struct ListIterator *it2;
-
-						dbmw_intersection(ztmp, se->dbm);
-						for (it2 = listIterator_first(se->resets) ; 
-								listIterator_hasNext(it2) ; it2 = 
-								listIterator_next(it2))
-						{
-							struct Clock *c = listIterator_val(it2);
-							dbmw_reset(ztmp, c);
-						}
-						listIterator_release(it2);
-
-						dbmw_intersection(ztmp, z2->dbm);
-						if (!dbmw_isEmpty(ztmp))
-							list_append(ret, zone_newcp(z2));
-						dbmw_free(ztmp);
-					}
-				}
-				listIterator_release(it2);
-			}
+			const struct StateEdge *se = z->s->outEdges[j];
+			if (se->to == z2->s && zoneGraph_edgeReaches(z, se, z2))
+				list_append(ret, zone_newcp(z2));
 		}
 	}
-	listIterator_release(it);
+	free(zones);
 
 	return ret;
 }
@@ -2873,6 +4353,7 @@ static struct ZoneGraph *zoneGraph_load(FILE *f, const struct Graph *g)
 	}
 
 	zg->a = g->a;
+	zg->dbms = dbmwTable_new();
 	zg->nbZones = (unsigned int)load_uint64(f);
 
 	z0Index = (unsigned int)load_uint64(f);
@@ -2900,6 +4381,7 @@ static struct ZoneGraph *zoneGraph_load(FILE *f, const struct Graph *g)
 	}
 	else
 		zg->sinkZone = NULL;
+	zoneGraph_computeTimeChains(zg);
 
 	return zg;
 }
@@ -2918,6 +4400,7 @@ static void zoneGraph_free(struct ZoneGraph *zg)
 	}
 
 	list_free(zg->zones, (void (*)(void *))zone_free);
+	dbmwTable_free(zg->dbms);
 
 	free(zg);
 }
@@ -2976,80 +4459,212 @@ static void graph_createChars(const struct List *l, struct List **psymbolTable,
 	listIterator_release(it);
 }
 
-static struct Tree *graph_computeStrings(const struct Graph *g)
+/**
+ * Computes the states of the buffer words, starting from the empty word. A 
+ * state is extended with each controllable event, until the array does not 
+ * change anymore. A state shared by several words is only extended once.
+ */
+static struct StringDag *graph_computeStrings(const struct Graph *g)
 {
-	struct Tree *t;
+	struct StringDag *d = stringDag_new(g->nbConts);
+	struct Fifo *toExtend = fifo_empty();
 	struct StringArray *root = stringArray_new(g);
+	int i, isNew;
 
-	t = tree_new(root);
-	graph_computeTree(t, g);
+	stringDag_add(d, root, &isNew);
+	root->isExtended = 1;
+	fifo_enqueue(toExtend, root);
 
-	return t;
-}
+	while (!fifo_isEmpty(toExtend))
+	{
+		const struct StringArray *sap = fifo_dequeue(toExtend);
 
-static void graph_computeTree(struct Tree *t, const struct Graph *g)
-{
-	struct StringArray *sap = tree_getData(t), *sa;
-	struct Tree *son;
-	int i;
+		for (i = 0 ; i < g->nbConts ; i++)
+		{
+			struct StringArray *sa = stringArray_newNext(sap, g, 
+					g->contsChars[i]);
+			int expand = !bitMatrix_areEqual(sa->array, sap->array);
+			unsigned int k = sap->index * d->nbConts + i;
+
+			d->succs[k] = stringDag_add(d, sa, &isNew);
+			d->expand[k] = expand;
+			sa = d->states[d->succs[k]];
+			if (expand && !sa->isExtended)
+			{
+				sa->isExtended = 1;
+				fifo_enqueue(toExtend, sa);
+			}
+		}
+	}
+	fifo_free(toExtend);
 
-	for (i = 0 ; i < g->nbConts ; i++)
-	{
-		sa = stringArray_newNext(sap, g, g->contsChars[i]);
+	return d;
+}
 
-		son = tree_new(sa);
-		tree_addSon(t, son);
-		if (!arraytwo_cmp(sa->array, sap->array))
-			graph_computeTree(son, g);
+/**
+ * Allocates the storage of nbNodes nodes, of which nbSuccSlices belong to 
+ * player 1, and of their words.
+ */
+static void graph_allocNodes(struct Graph *g, unsigned int nbNodes, unsigned int 
+		nbSuccSlices)
+{
+	g->allocNodes = nbNodes;
+	g->nodeArray = malloc(nbNodes * sizeof *(g->nodeArray));
+	g->allocSuccSlices = nbSuccSlices;
+	g->nbSuccSlices = 0;
+	g->succTable = malloc((size_t)nbSuccSlices * (g->nbConts + g->nbUnconts) * 
+			sizeof *(g->succTable));
+	if ((g->nodeArray == NULL && nbNodes > 0) || (g->succTable == NULL && 
+				nbSuccSlices * (g->nbConts + g->nbUnconts) > 0))
+	{
+		perror("malloc graph_allocNodes:g->nodeArray");
+		exit(EXIT_FAILURE);
 	}
+	g->words = wordArena_new();
 }
 
-static void graph_addNodes(struct Graph *g, struct Tree *stringArrays)
+/**
+ * Adds the nodes of all the zones, or with reachableOnly, only those of the 
+ * zones reachable from the initial zone (see graph_reachableZones). Each zone 
+ * has the nodes of all the words of strings, two per word.
+ */
+static void graph_addNodes(struct Graph *g, struct StringDag *strings, int 
+		reachableOnly)
 {
+	const struct Zone **zones;
 	struct ListIterator *it;
+	unsigned int i, n;
+	unsigned long nbWords;
 
-	for (it = listIterator_first(g->zoneGraph->zones) ; listIterator_hasNext(it) 
-			; it = listIterator_next(it))
+	if (reachableOnly)
+		zones = graph_reachableZones(g, &n);
+	else
 	{
-		struct Zone *z = listIterator_val(it);
-		graph_addNodesRec(g, z, stringArrays, NULL);
+		zones = malloc(g->zoneGraph->nbZones * sizeof *zones);
+		if (zones == NULL)
+		{
+			perror("malloc graph_addNodes:zones");
+			exit(EXIT_FAILURE);
+		}
+		n = 0;
+		for (it = listIterator_first(g->zoneGraph->zones) ; 
+				listIterator_hasNext(it) ; it = listIterator_next(it))
+			zones[n++] = listIterator_val(it);
+		listIterator_release(it);
 	}
-	listIterator_release(it);
 
-	g->nbNodes = list_size(g->nodes);
+	nbWords = (g->nbConts == 0) ? 1 : stringDag_nbWords(strings, 0);
+	graph_allocNodes(g, 2 * n * nbWords, n * nbWords);
+
+	for (i = 0 ; i < n ; i++)
+		graph_addNodesRec(g, zones[i], strings, 0, (g->nbConts == 0), "", NULL);
+	free(zones);
+}
+
+/**
+ * Returns the zones reachable from the initial zone, through the controllable, 
+ * uncontrollable and time successors of the zones, in the order they are met, 
+ * and sets *n to their number. Each node of a zone is reachable from its base 
+ * node, and the successors of the nodes are nodes of the successors of their 
+ * zone, so the nodes of these zones are exactly the nodes reachable from the 
+ * initial node. The winning nodes among them only depend on them, so 
+ * graph_computeW0 then solves the game locally.
+ */
+static const struct Zone **graph_reachableZones(const struct Graph *g, unsigned 
+		int *n)
+{
+	const struct Zone **zones = malloc(g->zoneGraph->nbZones * sizeof *zones);
+	unsigned char *reached = calloc(g->zoneGraph->nbZones, sizeof *reached);
+	unsigned int k, i, j, nbSuccs = g->nbConts + g->nbUnconts + 1;
+
+	if (zones == NULL || reached == NULL)
+	{
+		perror("malloc graph_reachableZones:zones");
+		exit(EXIT_FAILURE);
+	}
+
+	*n = 0;
+	if (g->zoneGraph->z0 != NULL)
+	{
+		zones[(*n)++] = g->zoneGraph->z0;
+		reached[g->zoneGraph->z0->index] = 1;
+	}
+	for (k = 0 ; k < *n ; k++)
+	{
+		const struct Zone *z = zones[k];
+
+		for (i = 0 ; i < nbSuccs ; i++)
+		{
+			const struct Zone *succ;
+
+			if (i < g->nbConts)
+				succ = z->contSuccs[i];
+			else if ((j = i - g->nbConts) < g->nbUnconts)
+				succ = z->uncontSuccs[j];
+			else
+				succ = z->timeSucc;
+			if (succ != NULL && !reached[succ->index])
+			{
+				reached[succ->index] = 1;
+				zones[(*n)++] = succ;
+			}
+		}
+	}
+	free(reached);
+
+	return zones;
 }
 
+/**
+ * Adds the nodes of the word word, whose state is strings->states[state], and 
+ * of its extensions. The subtree only depends on the state, but each word has 
+ * its own nodes.
+ */
 static void graph_addNodesRec(struct Graph *g, const struct Zone *z, const 
-		struct Tree *stringArrays, struct Node *pred)
+		struct StringDag *strings, unsigned int state, int isLeaf, const char 
+		*word, struct Node *pred)
 {
-	struct StringArray *sa;
 	struct Node *n[2];
-	int i, nbSons;
+	size_t length = strlen(word);
+	char *next;
+	int i;
 
-	sa = tree_getData(stringArrays);
 	for (i = 0 ; i < 2 ; i++)
 	{
-		n[i] = node_new(g, z, sa->s, i);
+		n[i] = node_new(g, z, word, i, g->nbNodes++);
 		list_append(g->nodes, n[i]);
 		list_append(g->nodesP[i], n[i]);
 	}
 
 	node_addEdgeStop(n[0], n[1]);
 	if (pred != NULL)
-		node_addEdgeCont(pred, n[0], graph_contIndex(g, sa->s[strlen(sa->s) - 
-					1]));
+		node_addEdgeCont(pred, n[0], graph_contIndex(g, word[length - 1]));
 	else
 		g->baseNodes[z->index] = n[0];
-	nbSons = tree_getNbSons(stringArrays);
-	if (nbSons == 0)
+	if (isLeaf)
 	{
 		n[0]->isLeaf = 1;
 		n[1]->isLeaf = 1;
+		return;
+	}
+
+	next = malloc(length + 2);
+	if (next == NULL)
+	{
+		perror("malloc graph_addNodesRec:next");
+		exit(EXIT_FAILURE);
 	}
-	for (i = 0 ; i < nbSons ; i++)
+	memcpy(next, word, length);
+	next[length + 1] = '\0';
+	for (i = 0 ; i < g->nbConts ; i++)
 	{
-		graph_addNodesRec(g, z, tree_getSon(stringArrays, i), n[1]);
+		unsigned int k = state * strings->nbConts + i;
+
+		next[length] = g->contsChars[i];
+		graph_addNodesRec(g, z, strings, strings->succs[k], 
+				!strings->expand[k], next, n[1]);
 	}
+	free(next);
 }
 
 static void graph_addEmitEdges(struct Graph *g)
@@ -3075,223 +4690,825 @@ static void graph_addEmitEdges(struct Graph *g)
 				char)(n->word[0])]->index]->index];
 		remain = n->word + 1;
 
-		while (*remain != '\0')
+		while (*remain != '\0')
+		{
+			next = node_succCont(g, next, *remain);
+			remain++;
+		}
+
+		node_addEdgeEmit(n, next);
+	}
+	listIterator_release(it);
+}
+
+static void graph_addUncontEdges(struct Graph *g)
+{
+	struct ListIterator *it;
+	char *remain;
+	struct Node *next;
+	int i;
+
+	for (it = listIterator_first(g->nodes) ; listIterator_hasNext(it) ; it = 
+			listIterator_next(it))
+	{
+		struct Node *n = listIterator_val(it);
+
+		if (n->owner == 0)
+			continue;
+
+		for (i = 0 ;  i < g->nbUnconts ; i++)
+		{
+			next = g->baseNodes[n->z->uncontSuccs[i]->index];
+
+			/* Do not loop */
+			if (next == n)
+				continue;
+
+			remain = n->word;
+
+			while (*remain != '\0')
+			{
+				next = node_succCont(g, next, *remain);
+				remain++;
+			}
+
+			node_addEdgeUncont(n, next, i);
+		}
+	}
+	listIterator_release(it);
+}
+
+static void graph_addTimeEdges(struct Graph *g)
+{
+	struct ListIterator *it;
+	char *remain;
+	struct Node *next;
+
+	for (it = listIterator_first(g->nodes) ; listIterator_hasNext(it) ; it = 
+			listIterator_next(it))
+	{
+		struct Node *n = listIterator_val(it);
+
+		if (n->owner == 0 || n->z->timeSucc == NULL)
+			continue;
+
+		next = g->baseNodes[n->z->timeSucc->index];
+
+		/* Do not loop */
+		if (next == n)
+			continue;
+
+		remain = n->word;
+
+		while (*remain != '\0')
+		{
+			next = node_succCont(g, next, *remain);
+			remain++;
+		}
+
+		node_addEdgeTime(n, next);
+	}
+	listIterator_release(it);
+}
+
+/**
+ * Builds the edges of the nodes of g and their predecessors (see struct Graph) 
+ * from the successors of the nodes, which must all be set.
+ */
+static void graph_buildEdges(struct Graph *g)
+{
+	unsigned int *succs, *next;
+	unsigned char *types;
+	unsigned int i, k, nb;
+
+	succs = malloc((g->nbConts + g->nbUnconts + 2) * sizeof *succs);
+	types = malloc((g->nbConts + g->nbUnconts + 2) * sizeof *types);
+	g->edgesStart = malloc((g->nbNodes + 1) * sizeof *(g->edgesStart));
+	g->predsStart = calloc(g->nbNodes + 1, sizeof *(g->predsStart));
+	next = malloc(g->nbNodes * sizeof *next);
+	if (succs == NULL || types == NULL || g->edgesStart == NULL || 
+			g->predsStart == NULL || (next == NULL && g->nbNodes > 0))
+	{
+		perror("malloc graph_buildEdges:g->edgesStart");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Counts the edges of each node and the predecessors of each node, then 
+	 * fills their slices */
+	g->edgesStart[0] = 0;
+	for (i = 0 ; i < g->nbNodes ; i++)
+	{
+		nb = node_listEdges(&(g->nodeArray[i]), succs, types);
+		g->edgesStart[i + 1] = g->edgesStart[i] + nb;
+		for (k = 0 ; k < nb ; k++)
+			g->predsStart[succs[k] + 1]++;
+	}
+	for (i = 0 ; i < g->nbNodes ; i++)
+	{
+		g->predsStart[i + 1] += g->predsStart[i];
+		next[i] = g->predsStart[i];
+	}
+
+	g->edgeSuccs = malloc(g->edgesStart[g->nbNodes] * sizeof 
+			*(g->edgeSuccs));
+	g->edgeTypes = malloc(g->edgesStart[g->nbNodes] * sizeof 
+			*(g->edgeTypes));
+	g->preds = malloc(g->edgesStart[g->nbNodes] * sizeof *(g->preds));
+	if ((g->edgeSuccs == NULL || g->edgeTypes == NULL || g->preds == NULL) && 
+			g->edgesStart[g->nbNodes] > 0)
+	{
+		perror("malloc graph_buildEdges:g->edgeSuccs");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0 ; i < g->nbNodes ; i++)
+	{
+		node_listEdges(&(g->nodeArray[i]), &(g->edgeSuccs[g->edgesStart[i]]), 
+				&(g->edgeTypes[g->edgesStart[i]]));
+		for (k = g->edgesStart[i] ; k < g->edgesStart[i + 1] ; k++)
+			g->preds[next[g->edgeSuccs[k]]++] = i;
+	}
+
+	free(next);
+	free(succs);
+	free(types);
+}
+
+/* Helper function to access the index of a controllable event */
+static inline unsigned int graph_contIndex(const struct Graph *g, char c)
+{
+	return g->contsEls[(unsigned char)c]->index;
+}
+
+/**
+ * Buchi game computation: computes in ret the nodes from which player 0 can 
+ * visit accepting nodes infinitely often. Safety and co-safety objectives only 
+ * need one attractor, the other ones are solved by graph_solveSccs.
+ */
+static void graph_computeW0(struct Graph *g, struct NodeSet *ret, struct 
+		ThreadPool *pool)
+{
+	struct Attractor *attr;
+
+	nodeSet_clear(ret);
+	attr = attractor_new(g, ret);
+
+	g->stats.objective = graph_computeObjective(g);
+	switch (g->stats.objective)
+	{
+		case OBJECTIVE_SAFETY:
+			graph_solveSafety(g, attr, pool);
+			break;
+		case OBJECTIVE_COSAFETY:
+			graph_solveCoSafety(g, attr, pool);
+			break;
+		default:
+			graph_solveSccs(g, attr, pool);
+			break;
+	}
+
+	attractor_free(attr);
+}
+
+/**
+ * Tells whether the accepting condition is a safety one (no edge of the zone 
+ * graph goes from a non-accepting state to an accepting one: player 0 must 
+ * never leave the accepting states) or a co-safety one (no edge goes from an 
+ * accepting state to a non-accepting one: player 0 must reach them once). The 
+ * edges of the game graph follow the ones of the zone graph, including those 
+ * to the sink zone, so that it holds for the game too.
+ */
+static enum Objective graph_computeObjective(const struct Graph *g)
+{
+	struct ListIterator *it, *it2;
+	int isSafety = 1, isCoSafety = 1;
+
+	for (it = listIterator_first(g->zoneGraph->zones) ; listIterator_hasNext(it) 
+			&& (isSafety || isCoSafety) ; it = listIterator_next(it))
+	{
+		const struct Zone *z = listIterator_val(it);
+
+		for (it2 = listIterator_first(z->edges) ; listIterator_hasNext(it2) ; 
+				it2 = listIterator_next(it2))
+		{
+			const struct ZoneEdge *e = listIterator_val(it2);
+
+			if (!z->s->isAccepting && e->succ->s->isAccepting)
+				isSafety = 0;
+			else if (z->s->isAccepting && !e->succ->s->isAccepting)
+				isCoSafety = 0;
+		}
+		listIterator_release(it2);
+	}
+	listIterator_release(it);
+
+	if (isSafety)
+		return OBJECTIVE_SAFETY;
+	if (isCoSafety)
+		return OBJECTIVE_COSAFETY;
+	return OBJECTIVE_BUCHI;
+}
+
+/**
+ * Safety objective: the non-accepting nodes are never left, so player 0 wins 
+ * outside of the attractor of player 1 to them. Player 0 still wins from the 
+ * non-accepting nodes from which he can force a node of player 1 without 
+ * successors, as the Buchi solver does, if there are such nodes: they are 
+ * removed first, by a second attractor.
+ */
+static void graph_solveSafety(const struct Graph *g, struct Attractor *attr, 
+		struct ThreadPool *pool)
+{
+	struct SubGame sub;
+	unsigned int i;
+	int hasDeadEnds = 0;
+
+	for (i = 0 ; i < g->nbNodes ; i++)
+	{
+		if (!g->nodeArray[i].isAccepting && g->nodeArray[i].owner == 1 && 
+				g->edgesStart[i] == g->edgesStart[i + 1])
+			hasDeadEnds = 1;
+	}
+
+	subGame_initAll(&sub, g, attr);
+	if (hasDeadEnds)
+	{
+		/* Restricted to the non-accepting nodes, which have no exit */
+		unsigned int k = 0;
+
+		for (i = 0 ; i < g->nbNodes ; i++)
+		{
+			if (!g->nodeArray[i].isAccepting)
+				sub.nodes[k++] = &(g->nodeArray[i]);
+			else
+				nodeSet_removeAtomic(attr->inSub, i);
+		}
+		sub.nbNodes = k;
+		graph_attr(attr->W, g, 0, attr->Tr, &sub, attr, pool);
+		free(sub.nodes);
+		subGame_initAll(&sub, g, attr);
+	}
+
+	for (i = 0 ; i < g->nbNodes ; i++)
+	{
+		if (!g->nodeArray[i].isAccepting && !(hasDeadEnds && 
+					nodeSet_inAtomic(attr->W, i)))
+			nodeSet_add(attr->R, i);
+	}
+
+	graph_attr(attr->W, g, 1, attr->R, &sub, attr, pool);
+	for (i = 0 ; i < g->nbNodes ; i++)
+	{
+		if (!nodeSet_inAtomic(attr->W, i))
+			nodeSet_add(attr->won, i);
+	}
+
+	free(sub.nodes);
+}
+
+/**
+ * Co-safety objective: the accepting nodes are never left, so player 0 wins in 
+ * the attractor of player 0 to them. Player 1 still wins from the accepting 
+ * nodes from which he can force a node of player 0 without successors, if 
+ * there are such nodes: they are removed first, by a second attractor.
+ */
+static void graph_solveCoSafety(const struct Graph *g, struct Attractor *attr, 
+		struct ThreadPool *pool)
+{
+	struct SubGame sub;
+	unsigned int i;
+	int hasDeadEnds = 0;
+
+	for (i = 0 ; i < g->nbNodes ; i++)
+	{
+		if (g->nodeArray[i].isAccepting && g->nodeArray[i].owner == 0 && 
+				g->edgesStart[i] == g->edgesStart[i + 1])
+			hasDeadEnds = 1;
+	}
+
+	subGame_initAll(&sub, g, attr);
+	if (hasDeadEnds)
+	{
+		/* Restricted to the accepting nodes, which have no exit */
+		unsigned int k = 0;
+
+		for (i = 0 ; i < g->nbNodes ; i++)
+		{
+			if (g->nodeArray[i].isAccepting)
+				sub.nodes[k++] = &(g->nodeArray[i]);
+			else
+				nodeSet_removeAtomic(attr->inSub, i);
+		}
+		sub.nbNodes = k;
+		graph_attr(attr->W, g, 1, attr->R, &sub, attr, pool);
+		free(sub.nodes);
+		subGame_initAll(&sub, g, attr);
+	}
+
+	for (i = 0 ; i < g->nbNodes ; i++)
+	{
+		if (g->nodeArray[i].isAccepting && !(hasDeadEnds && 
+					nodeSet_inAtomic(attr->W, i)))
+			nodeSet_add(attr->Tr, i);
+	}
+
+	graph_attr(attr->won, g, 0, attr->Tr, &sub, attr, pool);
+	free(sub.nodes);
+}
+
+/**
+ * Solves the game by strongly connected components, one by one, successors 
+ * first: the edges leaving a component then lead to nodes already solved. The 
+ * components of the same level, which do not reach each other, are solved in 
+ * parallel, and large components use the threads themselves.
+ */
+static void graph_solveSccs(struct Graph *g, struct Attractor *attr, struct 
+		ThreadPool *pool)
+{
+	struct Node **order = malloc(g->nbNodes * sizeof *order);
+	unsigned int *sccStart = malloc((g->nbNodes + 1) * sizeof *sccStart);
+	unsigned int *sccLevel = malloc(g->nbNodes * sizeof *sccLevel);
+	unsigned int *levelStart, *byLevel;
+	struct SubGame *subs;
+	struct SolveSccsArg arg;
+	unsigned int c, k, l, nbSccs, nbLevels = 0;
+
+	if (sccStart == NULL || ((order == NULL || sccLevel == NULL) && 
+				g->nbNodes > 0))
+	{
+		perror("malloc graph_solveSccs:order");
+		exit(EXIT_FAILURE);
+	}
+
+	nbSccs = graph_computeSccs(g, attr, order, sccStart, sccLevel);
+
+	subs = malloc(nbSccs * sizeof *subs);
+	byLevel = malloc(nbSccs * sizeof *byLevel);
+	if ((subs == NULL || byLevel == NULL) && nbSccs > 0)
+	{
+		perror("malloc graph_solveSccs:subs");
+		exit(EXIT_FAILURE);
+	}
+	for (c = 0 ; c < nbSccs ; c++)
+	{
+		subs[c].nodes = order + sccStart[c];
+		subs[c].nbNodes = sccStart[c + 1] - sccStart[c];
+		subs[c].frontier = attr->frontier + sccStart[c];
+		subs[c].next = attr->next + sccStart[c];
+		subs[c].nbNext = 0;
+		if (sccLevel[c] + 1 > nbLevels)
+			nbLevels = sccLevel[c] + 1;
+	}
+
+	/* Sorts the components by level */
+	levelStart = calloc(nbLevels + 1, sizeof *levelStart);
+	if (levelStart == NULL)
+	{
+		perror("calloc graph_solveSccs:levelStart");
+		exit(EXIT_FAILURE);
+	}
+	for (c = 0 ; c < nbSccs ; c++)
+		levelStart[sccLevel[c] + 1]++;
+	for (l = 0 ; l < nbLevels ; l++)
+		levelStart[l + 1] += levelStart[l];
+	for (c = 0 ; c < nbSccs ; c++)
+		byLevel[levelStart[sccLevel[c]]++] = c;
+	for (l = nbLevels ; l > 0 ; l--)
+		levelStart[l] = levelStart[l - 1];
+	levelStart[0] = 0;
+
+	arg.g = g;
+	arg.attr = attr;
+	arg.subs = subs;
+	for (l = 0 ; l < nbLevels ; l++)
+	{
+		unsigned int nbLevelNodes = 0;
+
+		arg.sccs = byLevel + levelStart[l];
+		for (k = levelStart[l] ; k < levelStart[l + 1] ; k++)
+			nbLevelNodes += subs[byLevel[k]].nbNodes;
+
+		if (nbLevelNodes < ATTR_PARALLELMIN)
+			graph_solveSccsSlice(&arg, 0, levelStart[l + 1] - levelStart[l], 
+					0);
+		else
+			threadPool_run(pool, levelStart[l + 1] - levelStart[l], 
+					graph_solveSccsSlice, &arg);
+
+		for (k = levelStart[l] ; k < levelStart[l + 1] ; k++)
 		{
-			next = node_succCont(g, next, *remain);
-			remain++;
+			if (subs[byLevel[k]].nbNodes >= ATTR_PARALLELMIN)
+				graph_solveSubGame(g, &(subs[byLevel[k]]), attr, pool);
 		}
-
-		node_addEdgeEmit(n, next);
 	}
-	listIterator_release(it);
+
+	g->stats.nbSccs = nbSccs;
+	g->stats.nbSccLevels = nbLevels;
+
+	free(order);
+	free(sccStart);
+	free(sccLevel);
+	free(subs);
+	free(byLevel);
+	free(levelStart);
 }
 
-static void graph_addUncontEdges(struct Graph *g)
-{
-	struct ListIterator *it;
-	char *remain;
-	struct Node *next;
-	int i;
+/**
+ * Computes the strongly connected components of the game with Tarjan's 
+ * algorithm, and returns their number. The nodes of the i-th component are 
+ * order[sccStart[i]] to order[sccStart[i + 1] - 1]. The components are found 
+ * successors first. sccLevel[i] is 0 if the i-th component has no edge 
+ * leaving it, and one more than the highest level of the components it leads 
+ * to otherwise.
+ */
+static unsigned int graph_computeSccs(const struct Graph *g, const struct 
+		Attractor *attr, struct Node **order, unsigned int *sccStart, unsigned 
+		int *sccLevel)
+{
+	/* num[i] = 0 while the node of index i is not visited */
+	unsigned int *num = calloc(g->nbNodes, sizeof *num);
+	unsigned int *low = malloc(g->nbNodes * sizeof *low);
+	unsigned int *sccOf = malloc(g->nbNodes * sizeof *sccOf);
+	unsigned int *stack = malloc(g->nbNodes * sizeof *stack);
+	/* Next successor to visit of each node being visited */
+	unsigned int *succ = malloc(g->nbNodes * sizeof *succ);
+	unsigned int *calls = malloc(g->nbNodes * sizeof *calls);
+	unsigned int i, j, k, v, s, nbVisited = 0, top = 0, nbCalls = 0, nbSccs = 
+				 0, nbOrdered = 0;
+
+	if ((num == NULL || low == NULL || sccOf == NULL || stack == NULL || succ 
+				== NULL || calls == NULL) && g->nbNodes > 0)
+	{
+		perror("malloc graph_computeSccs:num");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0 ; i < g->nbNodes ; i++)
+		sccOf[i] = UINT_MAX;
 
-	for (it = listIterator_first(g->nodes) ; listIterator_hasNext(it) ; it = 
-			listIterator_next(it))
+	for (i = 0 ; i < g->nbNodes ; i++)
 	{
-		struct Node *n = listIterator_val(it);
-
-		if (n->owner == 0)
+		if (num[i] != 0)
 			continue;
 
-		for (i = 0 ;  i < g->nbUnconts ; i++)
+		num[i] = low[i] = ++nbVisited;
+		stack[top++] = i;
+		succ[i] = g->edgesStart[i];
+		calls[nbCalls++] = i;
+
+		while (nbCalls > 0)
 		{
-			next = g->baseNodes[n->z->uncontSuccs[i]->index];
+			v = calls[nbCalls - 1];
+			if (succ[v] < g->edgesStart[v + 1])
+			{
+				s = g->edgeSuccs[succ[v]++];
+				if (num[s] == 0)
+				{
+					num[s] = low[s] = ++nbVisited;
+					stack[top++] = s;
+					succ[s] = g->edgesStart[s];
+					calls[nbCalls++] = s;
+				}
+				else if (sccOf[s] == UINT_MAX && num[s] < low[v])
+					low[v] = num[s];
+				continue;
+			}
 
-			/* Do not loop */
-			if (next == n)
+			nbCalls--;
+			if (nbCalls > 0 && low[v] < low[calls[nbCalls - 1]])
+				low[calls[nbCalls - 1]] = low[v];
+			if (low[v] != num[v])
 				continue;
 
-			remain = n->word;
+			/* v is the root of a component */
+			sccStart[nbSccs] = nbOrdered;
+			do
+			{
+				s = stack[--top];
+				sccOf[s] = nbSccs;
+				order[nbOrdered++] = &(g->nodeArray[s]);
+			} while (s != v);
 
-			while (*remain != '\0')
+			sccLevel[nbSccs] = 0;
+			for (k = sccStart[nbSccs] ; k < nbOrdered ; k++)
 			{
-				next = node_succCont(g, next, *remain);
-				remain++;
+				for (j = g->edgesStart[order[k]->index] ; j < 
+						g->edgesStart[order[k]->index + 1] ; j++)
+				{
+					s = sccOf[g->edgeSuccs[j]];
+					if (s != nbSccs && sccLevel[s] + 1 > sccLevel[nbSccs])
+						sccLevel[nbSccs] = sccLevel[s] + 1;
+				}
 			}
-
-			node_addEdgeUncont(n, next, i);
+			nbSccs++;
 		}
 	}
-	listIterator_release(it);
+	sccStart[nbSccs] = nbOrdered;
+
+	free(num);
+	free(low);
+	free(sccOf);
+	free(stack);
+	free(succ);
+	free(calls);
+
+	return nbSccs;
 }
 
-static void graph_addTimeEdges(struct Graph *g)
+/* Solves the small components of arg->sccs [begin, end) */
+static void graph_solveSccsSlice(void *parg, unsigned int begin, unsigned int 
+		end, unsigned int worker)
 {
-	struct ListIterator *it;
-	char *remain;
-	struct Node *next;
+	struct SolveSccsArg *arg = parg;
+	unsigned int k;
+	(void)worker;
 
-	for (it = listIterator_first(g->nodes) ; listIterator_hasNext(it) ; it = 
-			listIterator_next(it))
+	for (k = begin ; k < end ; k++)
 	{
-		struct Node *n = listIterator_val(it);
+		struct SubGame *sub = &(arg->subs[arg->sccs[k]]);
+		if (sub->nbNodes < ATTR_PARALLELMIN)
+			graph_solveSubGame(arg->g, sub, arg->attr, NULL);
+	}
+}
 
-		if (n->owner == 0 || n->z->timeSucc == NULL)
-			continue;
+/**
+ * Solves the Buchi game on the nodes of sub, whose successors outside sub are 
+ * already solved, and adds its winning nodes to attr->won. sub->nodes is 
+ * reordered. If pool is not NULL, the attractors use its threads.
+ */
+static void graph_solveSubGame(const struct Graph *g, struct SubGame *sub, 
+		struct Attractor *attr, struct ThreadPool *pool)
+{
+	unsigned int k, m, nbRemoved;
 
-		next = g->baseNodes[n->z->timeSucc->index];
+	for (k = 0 ; k < sub->nbNodes ; k++)
+		nodeSet_addAtomic(attr->inSub, sub->nodes[k]->index);
 
-		/* Do not loop */
-		if (next == n)
-			continue;
+	do
+	{
+		graph_attr(attr->R, g, 0, attr->accepting, sub, attr, pool);
 
-		remain = n->word;
+		/* Tr = sub \ R */
+		for (k = 0 ; k < sub->nbNodes ; k++)
+		{
+			unsigned int j = sub->nodes[k]->index;
+			if (nodeSet_inAtomic(attr->R, j))
+				nodeSet_removeAtomic(attr->Tr, j);
+			else
+				nodeSet_addAtomic(attr->Tr, j);
+		}
 
-		while (*remain != '\0')
+		/* The nodes of W are winning for player 1 */
+		graph_attr(attr->W, g, 1, attr->Tr, sub, attr, pool);
+		for (k = 0, m = 0 ; k < sub->nbNodes ; k++)
 		{
-			next = node_succCont(g, next, *remain);
-			remain++;
+			struct Node *n = sub->nodes[k];
+			if (nodeSet_inAtomic(attr->W, n->index))
+				nodeSet_removeAtomic(attr->inSub, n->index);
+			else
+				sub->nodes[m++] = n;
 		}
+		nbRemoved = sub->nbNodes - m;
+		sub->nbNodes = m;
+	} while (nbRemoved > 0 && sub->nbNodes > 0);
 
-		node_addEdgeTime(n, next);
+	for (k = 0 ; k < sub->nbNodes ; k++)
+	{
+		nodeSet_addAtomic(attr->won, sub->nodes[k]->index);
+		nodeSet_removeAtomic(attr->inSub, sub->nodes[k]->index);
 	}
-	listIterator_release(it);
 }
 
-/* Helper function to access the index of a controllable event */
-static inline unsigned int graph_contIndex(const struct Graph *g, char c)
+/**
+ * Computes in ret the attractor of U for player in the subgame sub: on the 
+ * nodes of sub, ret is set to the nodes from which player can force a visit to 
+ * U. The successors outside sub are already solved, and attr->won tells which 
+ * player wins from them.
+ * A node is added when one of its successors is (player's nodes) or when all 
+ * of them are (opponent's nodes), which is detected by counting the successors 
+ * left, so that each edge is only followed once, backwards.
+ * The attractor grows by frontiers: the nodes added from a frontier form the 
+ * next one. If pool is not NULL, large frontiers are split between its 
+ * threads.
+ */
+static void graph_attr(struct NodeSet *ret, const struct Graph *g, int player, 
+		const struct NodeSet *U, struct SubGame *sub, struct Attractor *attr, 
+		struct ThreadPool *pool)
 {
-	return g->contsEls[(unsigned char)c]->index;
+	struct AttrArg arg;
+	struct Node **tmp;
+	unsigned int n;
+
+	arg.g = g;
+	arg.attr = attr;
+	arg.sub = sub;
+	arg.ret = ret;
+	arg.U = U;
+	arg.player = player;
+
+	sub->nbNext = 0;
+	if (pool == NULL || sub->nbNodes < ATTR_PARALLELMIN)
+		graph_attrInitSlice(&arg, 0, sub->nbNodes, 0);
+	else
+		threadPool_run(pool, sub->nbNodes, graph_attrInitSlice, &arg);
+
+	while (sub->nbNext > 0)
+	{
+		tmp = sub->frontier;
+		sub->frontier = sub->next;
+		sub->next = tmp;
+		n = sub->nbNext;
+		sub->nbNext = 0;
+
+		if (pool == NULL || n < ATTR_PARALLELMIN)
+			graph_attrFrontierSlice(&arg, 0, n, 0);
+		else
+			threadPool_run(pool, n, graph_attrFrontierSlice, &arg);
+	}
 }
 
-/* Buchi game computation */
-static void graph_computeW0(struct Graph *g, struct Set *ret)
+/**
+ * Counts the successors left of the nodes [begin, end) of the subgame, and 
+ * starts the attractor with them. A successor outside the subgame is never 
+ * left when it is winning for player, and always otherwise.
+ */
+static void graph_attrInitSlice(void *parg, unsigned int begin, unsigned int 
+		end, unsigned int worker)
 {
-	struct List *S = list_new();
-	struct ListIterator *it;
-	struct Set *B = set_empty(NULL);
-	struct Set *R = set_empty(NULL);
-	struct Set *Tr = set_empty(NULL);
-	struct Set *W = set_empty(NULL);
-	struct Set *Sset = set_empty(NULL);
+	struct AttrArg *arg = parg;
+	struct Attractor *attr = arg->attr;
+	unsigned int i, k;
+	(void)worker;
 
-	for (it = listIterator_first(g->nodes) ; listIterator_hasNext(it) ; it = 
-			listIterator_next(it))
+	for (k = begin ; k < end ; k++)
 	{
-		struct Node *n = listIterator_val(it);
-		list_append(S, n);
-		set_add(Sset, n);
-		if (n->isAccepting)
-			set_add(B, n);
+		struct Node *n = arg->sub->nodes[k];
+		unsigned int nbLeft = 0;
+		int exits = 0;
+
+		for (i = arg->g->edgesStart[n->index] ; i < 
+				arg->g->edgesStart[n->index + 1] ; i++)
+		{
+			unsigned int s = arg->g->edgeSuccs[i];
+
+			if (nodeSet_inAtomic(attr->inSub, s))
+				nbLeft++;
+			else if (nodeSet_inAtomic(attr->won, s) == (arg->player == 0))
+				exits = 1;
+			else
+				nbLeft++;
+		}
+		attr->nbSuccsLeft[n->index] = nbLeft;
+
+		if (nodeSet_inAtomic(arg->U, n->index) || (n->owner == arg->player ? 
+					exits : nbLeft == 0))
+		{
+			nodeSet_addAtomic(arg->ret, n->index);
+			subGame_push(arg->sub, n);
+		}
+		else
+			nodeSet_removeAtomic(arg->ret, n->index);
 	}
-	listIterator_release(it);
-	set_reset(ret);
+}
 
-	do
+/**
+ * Adds to the attractor the predecessors of the nodes [begin, end) of the 
+ * frontier that it now attracts. The counters and ret are shared between the 
+ * threads and only updated atomically: a node is pushed by the thread that 
+ * adds it to ret.
+ */
+static void graph_attrFrontierSlice(void *parg, unsigned int begin, unsigned 
+		int end, unsigned int worker)
+{
+	struct AttrArg *arg = parg;
+	struct Attractor *attr = arg->attr;
+	unsigned int i, k;
+	(void)worker;
+
+	for (k = begin ; k < end ; k++)
 	{
-		graph_attr(R, g, 0, B, S);
+		struct Node *n = arg->sub->frontier[k];
 
-		/* Tr = S \ B */
-		set_reset(Tr);
-		for (it = listIterator_first(S) ; listIterator_hasNext(it) ; it = 
-				listIterator_next(it))
+		for (i = arg->g->predsStart[n->index] ; i < 
+				arg->g->predsStart[n->index + 1] ; i++)
 		{
-			set_add(Tr, listIterator_val(it));
-		}
-		listIterator_release(it);
-		set_remove(Tr, (int (*)(const void *, const void *))set_in, R);
+			struct Node *pred = &(arg->g->nodeArray[arg->g->preds[i]]);
 
-		graph_attr(W, g, 1, Tr, S);
-		removeSetFromList(S, W);
+			if (!nodeSet_inAtomic(attr->inSub, pred->index) || 
+					nodeSet_inAtomic(arg->ret, pred->index))
+				continue;
+			if ((pred->owner == arg->player || 
+						__atomic_sub_fetch(&(attr->nbSuccsLeft[pred->index]), 
+							1, __ATOMIC_RELAXED) == 0) && 
+					nodeSet_addAtomic(arg->ret, pred->index))
+				subGame_push(arg->sub, pred);
+		}
+	}
+}
 
-		set_remove(B, (int (*)(const void *, const void *))set_in, W);
-		set_applyToAll(W, (void (*)(void *, void *))set_add, ret);
-	} while (!set_isEmpty(W));
+/* SubGame */
+/**
+ * Fills sub with all the nodes of the game, which must be freed with 
+ * free(sub->nodes).
+ */
+static void subGame_initAll(struct SubGame *sub, const struct Graph *g, struct 
+		Attractor *attr)
+{
+	unsigned int i;
 
-	/* ret = S \ ret */
-	set_copy(W, ret, NULL);
-	set_copy(ret, Sset, NULL);
-	set_remove(ret, (int (*)(const void *, const void *))set_in, W);
+	sub->nodes = malloc(g->nbNodes * sizeof *(sub->nodes));
+	if (sub->nodes == NULL && g->nbNodes > 0)
+	{
+		perror("malloc subGame_initAll:sub->nodes");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0 ; i < g->nbNodes ; i++)
+	{
+		sub->nodes[i] = &(g->nodeArray[i]);
+		nodeSet_add(attr->inSub, i);
+	}
+	sub->nbNodes = g->nbNodes;
+	sub->frontier = attr->frontier;
+	sub->next = attr->next;
+	sub->nbNext = 0;
+}
 
-	list_free(S, NULL);
-	set_free(B);
-	set_free(R);
-	set_free(Tr);
-	set_free(W);
-	set_free(Sset);
+/* Adds n to the next frontier of sub. Safe with concurrent subGame_push */
+static inline void subGame_push(struct SubGame *sub, struct Node *n)
+{
+	sub->next[__atomic_fetch_add(&(sub->nbNext), 1, __ATOMIC_RELAXED)] = n;
 }
 
-static void graph_attr(struct Set *ret, struct Graph *g, int player, const 
-		struct Set *U, struct List *nodes)
+/* Attractor */
+static struct Attractor *attractor_new(const struct Graph *g, struct NodeSet 
+		*won)
 {
-	int stable = 0;
-	struct ListIterator *it, *it2;
+	struct Attractor *ret = malloc(sizeof *ret);
+	unsigned int i;
 
-	set_reset(ret);
-	set_copy(ret, U, NULL);
+	if (ret == NULL)
+	{
+		perror("malloc attractor_new:ret");
+		exit(EXIT_FAILURE);
+	}
 
-	while (!stable)
+	ret->won = won;
+	ret->inSub = nodeSet_new(g->nbNodes);
+	ret->accepting = nodeSet_new(g->nbNodes);
+	ret->R = nodeSet_new(g->nbNodes);
+	ret->Tr = nodeSet_new(g->nbNodes);
+	ret->W = nodeSet_new(g->nbNodes);
+	for (i = 0 ; i < g->nbNodes ; i++)
 	{
-		stable = 1;
+		if (g->nodeArray[i].isAccepting)
+			nodeSet_add(ret->accepting, i);
+	}
 
-		for (it = listIterator_first(nodes) ; listIterator_hasNext(it) ; it = 
-				listIterator_next(it))
-		{
-			struct Node *n = listIterator_val(it);
-			if (set_in(ret, n))
-				continue;
-			if (n->owner == player)
-			{
-				for (it2 = listIterator_first(n->edges) ; 
-						listIterator_hasNext(it2) ; it2 = 
-						listIterator_next(it2))
-				{
-					struct Edge *e = listIterator_val(it2);
-					if (listIn(nodes, e->succ) && set_in(ret, e->succ))
-					{
-						stable = 0;
-						set_add(ret, n);
-						break;
-					}
-				}
-				listIterator_release(it2);
-			}
-			/* n->owner != player */
-			else
-			{
-				int ok = 1;
+	ret->nbSuccsLeft = malloc(g->nbNodes * sizeof *(ret->nbSuccsLeft));
+	ret->frontier = malloc(g->nbNodes * sizeof *(ret->frontier));
+	ret->next = malloc(g->nbNodes * sizeof *(ret->next));
+	if ((ret->nbSuccsLeft == NULL || ret->frontier == NULL || ret->next == 
+				NULL) && g->nbNodes > 0)
+	{
+		perror("malloc attractor_new:ret->nbSuccsLeft");
+		exit(EXIT_FAILURE);
+	}
 
-				for (it2 = listIterator_first(n->edges) ; 
-						listIterator_hasNext(it2) ; it2 = 
-						listIterator_next(it2))
-				{
-					struct Edge *e = listIterator_val(it2);
-					if (listIn(nodes, e->succ) && !set_in(ret, e->succ))
-						ok = 0;
-				}
-				listIterator_release(it2);
+	return ret;
+}
 
-				if (ok)
-				{
-					stable = 0;
-					set_add(ret, n);
-				}
-			}
-		}
-		listIterator_release(it);
-	}
+static void attractor_free(struct Attractor *attr)
+{
+	free(attr->nbSuccsLeft);
+	free(attr->frontier);
+	free(attr->next);
+	nodeSet_free(attr->inSub);
+	nodeSet_free(attr->accepting);
+	nodeSet_free(attr->R);
+	nodeSet_free(attr->Tr);
+	nodeSet_free(attr->W);
+	free(attr);
 }
 
-/* Graph public interface */
-struct Graph *graph_newFromAutomaton(const char *filename)
+/**
+ * Builds the graph of the automaton of filename. If old is not NULL, the zones 
+ * of old are reused where the automaton did not change.
+ */
+static struct Graph *graph_build(const char *filename, const struct Graph *old, 
+		const struct GraphOptions *opts)
 {
 	const struct List *pstates = NULL;
 	const struct List *pconts = NULL;
 	const struct List *punconts = NULL;
 	const struct List *pedges = NULL;
 	const struct List *pclocks = NULL;
-	struct Tree *strings;
+	struct StringDag *strings;
 	struct Graph *g = malloc(sizeof *g);
-	struct Set *W0 = set_empty(NULL);
+	struct NodeSet *W0;
+	struct ThreadPool *pool;
+	struct PhaseTimer timer;
+	const struct State **oldStates = NULL;
+	int *unstable = NULL;
 	int i;
+	unsigned int j;
 
 	if (g == NULL)
 	{
@@ -3299,7 +5516,10 @@ struct Graph *graph_newFromAutomaton(const char *filename)
 		exit(EXIT_FAILURE);
 	}
 	
+	pool = threadPool_new(opts->nbThreads);
+	graphStats_init(&(g->stats));
 
+	graphStats_startPhase(&timer, pool);
 	parseFile(filename);
 
 	pstates = parser_getStates();
@@ -3311,6 +5531,7 @@ struct Graph *graph_newFromAutomaton(const char *filename)
 	g->nodes = list_new();
 	g->nodesP[0] = list_new();
 	g->nodesP[1] = list_new();
+	g->nbNodes = 0;
 	g->nbConts = parser_getNbConts();
 	g->nbUnconts = parser_getNbUnconts();
 
@@ -3322,36 +5543,117 @@ struct Graph *graph_newFromAutomaton(const char *filename)
 	graph_createChars(pconts, &(g->contsTable), &(g->contsChars), g->contsEls);
 	graph_createChars(punconts, &(g->uncontsTable), &(g->uncontsChars), 
 			g->uncontsEls);
+	graphStats_endPhase(&(g->stats), GRAPHPHASE_PARSE, &timer, pool);
 
+	graphStats_startPhase(&timer, pool);
 	g->a = timedAutomaton_new(g->contsTable, (const struct SymbolTableEl 
 				**)g->contsEls, g->uncontsTable, (const struct SymbolTableEl 
 					**)g->uncontsEls, pstates, pclocks, pedges);
 	clocks = g->a->clocks;
-	g->zoneGraph = zoneGraph_new(g->a);
-	g->baseNodes = malloc(g->zoneGraph->nbZones * sizeof (*g->baseNodes));
+	if (old != NULL)
+	{
+		unstable = malloc(g->a->nbStates * sizeof *unstable);
+		if (unstable == NULL)
+		{
+			perror("malloc graph_build:unstable");
+			exit(EXIT_FAILURE);
+		}
+		oldStates = timedAutomaton_diff(g->a, old->a, unstable);
+	}
+	graphStats_endPhase(&(g->stats), GRAPHPHASE_AUTOMATON, &timer, pool);
+
+	g->zoneGraph = zoneGraph_new(g->a, (oldStates != NULL) ? old->zoneGraph : 
+			NULL, oldStates, unstable, opts, pool, &(g->stats));
+	free(oldStates);
+	free(unstable);
+	g->nbZones = g->zoneGraph->nbZones;
+	/* With opts->reachableOnly, the zones that are not reachable have no nodes */
+	g->baseNodes = calloc(g->zoneGraph->nbZones, sizeof (*g->baseNodes));
 	if (g->baseNodes == NULL)
 	{
-		perror("malloc graph_newFromAutomaton:g->baseNodes");
+		perror("calloc graph_build:g->baseNodes");
 		exit(EXIT_FAILURE);
 	}
 
+	graphStats_startPhase(&timer, pool);
 	strings = graph_computeStrings(g);
-	graph_addNodes(g, strings);
-	tree_free(strings, (void (*)(void *))stringArray_free);
+	graphStats_endPhase(&(g->stats), GRAPHPHASE_STRINGS, &timer, pool);
+
+	graphStats_startPhase(&timer, pool);
+	graph_addNodes(g, strings, opts->reachableOnly);
+	g->stats.nbStrings = strings->nbStates;
+	stringDag_free(strings);
+	graphStats_endPhase(&(g->stats), GRAPHPHASE_NODES, &timer, pool);
+
+	graphStats_startPhase(&timer, pool);
 	graph_addEmitEdges(g);
 	graph_addUncontEdges(g);
 	graph_addTimeEdges(g);
-	graph_computeW0(g, W0);
-	
-	set_applyToAll(W0, node_setWinning, NULL);
-	set_applyToAll(W0, (void (*)(void *, void *))node_computeStrat, NULL);
+	graph_buildEdges(g);
+	graphStats_endPhase(&(g->stats), GRAPHPHASE_EDGES, &timer, pool);
+
+	graphStats_startPhase(&timer, pool);
+	W0 = nodeSet_new(g->nbNodes);
+	graph_computeW0(g, W0, pool);
+
+	for (j = nodeSet_next(W0, 0) ; j < g->nbNodes ; j = nodeSet_next(W0, j + 
+				1))
+		g->nodeArray[j].isWinning = 1;
+	for (j = nodeSet_next(W0, 0) ; j < g->nbNodes ; j = nodeSet_next(W0, j + 
+				1))
+		node_computeStrat(&(g->nodeArray[j]));
+	graphStats_endPhase(&(g->stats), GRAPHPHASE_SOLVE, &timer, pool);
+
+	g->stats.nbZones = g->nbZones;
+	g->stats.nbNodes = g->nbNodes;
 
 	parser_cleanup();
-	set_free(W0);
+	nodeSet_free(W0);
+	threadPool_free(pool);
 
 	return g;
 }
 
+/* Graph public interface */
+void graphOptions_init(struct GraphOptions *opts)
+{
+	opts->nbThreads = 1;
+	opts->parallelRefinement = 0;
+	opts->reachableOnly = 0;
+}
+
+struct Graph *graph_newFromAutomaton(const char *filename)
+{
+	struct GraphOptions opts;
+
+	graphOptions_init(&opts);
+
+	return graph_newFromAutomatonOpts(filename, &opts);
+}
+
+struct Graph *graph_newFromAutomatonOpts(const char *filename, const struct 
+		GraphOptions *opts)
+{
+	return graph_build(filename, NULL, opts);
+}
+
+/**
+ * Builds the graph of the automaton of filename, which is a modified version of 
+ * the one of old: the states whose edges changed are refined from scratch, and 
+ * the zones of old for the ones that can reach them are split again. If the 
+ * events or the clocks changed, or if this concerns more than half of the 
+ * states, the graph is built from scratch.
+ * The refinement starts from the zones of old, and may keep splits that only 
+ * the old guards needed. The zone graph is stable, hence as valid, but it may 
+ * differ from the one built by graph_newFromAutomatonOpts, and have more (or 
+ * fewer) zones.
+ */
+struct Graph *graph_updateFromAutomaton(const struct Graph *old, const char 
+		*filename, const struct GraphOptions *opts)
+{
+	return graph_build(filename, old, opts);
+}
+
 const struct List *graph_getNodes(const struct Graph *g)
 {
 	return g->nodes;
@@ -3362,6 +5664,11 @@ const struct ZoneGraph *graph_getZoneGraph(const struct Graph *g)
 	return g->zoneGraph;
 }
 
+const struct GraphStats *graph_getStats(const struct Graph *g)
+{
+	return &(g->stats);
+}
+
 void graph_save(const struct Graph *g, const char *filename)
 {
 	FILE *file = fopen(filename, "w");
@@ -3436,6 +5743,7 @@ struct Graph *graph_load(const char *filename)
 		perror("malloc graph_load:g");
 		exit(EXIT_FAILURE);
 	}
+	graphStats_init(&(g->stats));
 
 	g->nbConts = (unsigned int)load_uint64(f);
 	g->contsChars = malloc(g->nbConts + 1);
@@ -3445,7 +5753,7 @@ struct Graph *graph_load(const char *filename)
 		exit(EXIT_FAILURE);
 	}
 	g->contsTable = list_new();
-	for (i = 0 ; i < NBSUCCS ; i++)
+	for (i = 0 ; i < 256 ; i++)
 	{
 		g->contsEls[i] = NULL;
 	}
@@ -3465,7 +5773,7 @@ struct Graph *graph_load(const char *filename)
 		exit(EXIT_FAILURE);
 	}
 	g->uncontsTable = list_new();
-	for (i = 0 ; i < NBSUCCS ; i++)
+	for (i = 0 ; i < 256 ; i++)
 	{
 		g->uncontsEls[i] = NULL;
 	}
@@ -3509,14 +5817,16 @@ struct Graph *graph_load(const char *filename)
 	g->nbNodes = (unsigned int)load_uint64(f);
 	g->nodesP[0] = list_new();
 	g->nodesP[1] = list_new();
-	g->baseNodes = malloc(g->zoneGraph->nbZones * sizeof (*g->baseNodes));
+	g->baseNodes = calloc(g->zoneGraph->nbZones, sizeof (*g->baseNodes));
 	if (g->baseNodes == NULL)
 	{
-		perror("malloc graph_newFromAutomaton:g->baseNodes");
+		perror("calloc graph_load:g->baseNodes");
 		exit(EXIT_FAILURE);
 	}
 
+	graph_allocNodes(g, g->nbNodes, g->nbNodes);
 	g->nodes = node_loadAll(f, g);
+	graph_buildEdges(g);
 	for (it = listIterator_first(g->nodes) ; listIterator_hasNext(it) ; it = 
 			listIterator_next(it))
 	{
@@ -3554,7 +5864,15 @@ void graph_free(struct Graph *g)
 {
 	list_free(g->nodesP[0], NULL);
 	list_free(g->nodesP[1], NULL);
-	list_free(g->nodes, (void (*)(void *))node_free);
+	list_free(g->nodes, NULL);
+	free(g->nodeArray);
+	free(g->succTable);
+	free(g->edgesStart);
+	free(g->edgeSuccs);
+	free(g->edgeTypes);
+	free(g->predsStart);
+	free(g->preds);
+	wordArena_free(g->words);
 	free(g->baseNodes);
 
 	zoneGraph_free(g->zoneGraph);
@@ -3569,6 +5887,145 @@ void graph_free(struct Graph *g)
 }
 
 
+/* GraphStats */
+/* GraphStats private interface */
+static void graphStats_init(struct GraphStats *stats)
+{
+	memset(stats, 0, sizeof *stats);
+}
+
+static double timespec_diff(const struct timespec *t1, const struct timespec 
+		*t0)
+{
+	return (double)(t1->tv_sec - t0->tv_sec) + (double)(t1->tv_nsec - 
+			t0->tv_nsec) / 1e9;
+}
+
+static void graphStats_countDbmOpsSlice(void *parg, unsigned int begin, 
+		unsigned int end, unsigned int worker)
+{
+	unsigned long *nbOps = parg;
+
+	(void)begin;
+	(void)end;
+	nbOps[worker] = dbmw_nbOps();
+}
+
+/**
+ * Returns the number of DBM operations performed so far by all the threads of 
+ * pool. The counters are thread-local, so each worker reports its own.
+ */
+static unsigned long graphStats_countDbmOps(struct ThreadPool *pool)
+{
+	unsigned int i, n = threadPool_nbThreads(pool);
+	unsigned long *nbOps, ret;
+
+	nbOps = calloc(n, sizeof *nbOps);
+	if (nbOps == NULL)
+	{
+		perror("calloc graphStats_countDbmOps:nbOps");
+		exit(EXIT_FAILURE);
+	}
+	/* One index per thread, so that every worker gets called */
+	threadPool_run(pool, n, graphStats_countDbmOpsSlice, nbOps);
+	ret = 0;
+	for (i = 0 ; i < n ; i++)
+		ret += nbOps[i];
+	free(nbOps);
+
+	return ret;
+}
+
+static void graph_releaseDbmwPoolsSlice(void *arg, unsigned int begin, 
+		unsigned int end, unsigned int worker)
+{
+	(void)arg;
+	(void)begin;
+	(void)end;
+	(void)worker;
+	dbmw_releasePool();
+}
+
+/**
+ * Releases the DBMs kept by the pools of all the threads of pool, once the 
+ * temporary DBMs of the zone graph construction are not needed any more.
+ */
+static void graph_releaseDbmwPools(struct ThreadPool *pool)
+{
+	/* One index per thread, so that every worker gets called */
+	threadPool_run(pool, threadPool_nbThreads(pool), 
+			graph_releaseDbmwPoolsSlice, NULL);
+}
+
+static void graphStats_startPhase(struct PhaseTimer *timer, struct ThreadPool 
+		*pool)
+{
+	timer->nbDbmOps = graphStats_countDbmOps(pool);
+	clock_gettime(CLOCK_MONOTONIC, &(timer->wall));
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &(timer->cpu));
+}
+
+static void graphStats_endPhase(struct GraphStats *stats, enum GraphPhase 
+		phase, const struct PhaseTimer *timer, struct ThreadPool *pool)
+{
+	struct GraphPhaseStats *ps = &(stats->phases[phase]);
+	struct timespec wall, cpu;
+
+	clock_gettime(CLOCK_MONOTONIC, &wall);
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+	ps->wallTime = timespec_diff(&wall, &(timer->wall));
+	ps->cpuTime = timespec_diff(&cpu, &(timer->cpu));
+	ps->nbDbmOps = graphStats_countDbmOps(pool) - timer->nbDbmOps;
+#ifdef HAVE_MALLINFO2
+	{
+		struct mallinfo2 mi = mallinfo2();
+		ps->allocatedBytes = mi.uordblks + mi.hblkhd;
+	}
+#else
+	ps->allocatedBytes = 0;
+#endif
+	if (ps->allocatedBytes > stats->maxPhaseEndAllocatedBytes)
+		stats->maxPhaseEndAllocatedBytes = ps->allocatedBytes;
+}
+
+/* GraphStats public interface */
+void graphStats_print(const struct GraphStats *stats, FILE *f)
+{
+	static const char *phaseNames[GRAPHPHASE_NB] = {"parse", "automaton", 
+		"refinement", "zone succs", "strings", "nodes", "edges", "solve"};
+	double wallTime = 0, cpuTime = 0;
+	unsigned long nbDbmOps = 0;
+	int i;
+
+	fprintf(f, "%-12s %12s %12s %14s %14s\n", "phase", "wall (s)", "cpu (s)", 
+			"dbm ops", "end alloc (B)");
+	for (i = 0 ; i < GRAPHPHASE_NB ; i++)
+	{
+		const struct GraphPhaseStats *ps = &(stats->phases[i]);
+		fprintf(f, "%-12s %12.6f %12.6f %14lu %14zu\n", phaseNames[i], 
+				ps->wallTime, ps->cpuTime, ps->nbDbmOps, ps->allocatedBytes);
+		wallTime += ps->wallTime;
+		cpuTime += ps->cpuTime;
+		nbDbmOps += ps->nbDbmOps;
+	}
+	fprintf(f, "%-12s %12.6f %12.6f %14lu\n", "total", wallTime, cpuTime, 
+			nbDbmOps);
+	fprintf(f, "refinement: %lu iterations, %lu splits, at most %u zones\n", 
+			stats->nbRefineIterations, stats->nbSplits, stats->peakZones);
+	fprintf(f, "graph: %u zones (%u distinct DBMs), %u buffer states, %u " 
+			"nodes, at most %zu bytes allocated at the end of a phase\n", 
+			stats->nbZones, stats->nbDbms, stats->nbStrings, stats->nbNodes, 
+			stats->maxPhaseEndAllocatedBytes);
+	if (stats->objective == OBJECTIVE_BUCHI)
+		fprintf(f, "solve: Buchi objective, %u strongly connected components " 
+				"in %u levels\n", stats->nbSccs, stats->nbSccLevels);
+	else
+		fprintf(f, "solve: %s objective, attractor solver\n", 
+				(stats->objective == OBJECTIVE_SAFETY) ? "safety" : 
+				"co-safety");
+}
+
+
 /* StratNode */
 static struct StratNode *stratNode_new(const struct Node *n, int score, struct 
 		List *l, struct ListIterator *it)
@@ -4443,7 +6900,7 @@ static unsigned int enforcer_emitFast(struct Enforcer *e)
 	struct SymbolTableEl *sym;
 	struct TimedEvent *te;
 	struct ListIterator *it;
-	struct Dbmw *prevZone = e->realNode->z->dbm;
+	const struct Dbmw *prevZone = e->realNode->z->dbm;
 
 	if (e->realNode->word[0] == '\0')
 	{
@@ -4597,14 +7054,19 @@ static unsigned int enforcer_delayFast(struct Enforcer *e, unsigned int delay)
 		e->valuation[i] += delay;
 	}
 
-	while (!dbmw_isPointIncluded(e->realNode->z->dbm, e->valuation))
+	if (!dbmw_isPointIncluded(e->realNode->z->dbm, e->valuation))
 	{
+		const struct Zone *z = e->realNode->z;
+		int k = dbmw_firstIncluding(z->timeChain, z->timeChainLength, 
+				e->valuation);
+
 		changed = 1;
 #ifdef ENFORCER_PRINT_LOG
 		//fprintf(e->log, "Switching to next zone\n");
 #endif
-		e->realNode = e->realNode->p0.succStopEmit->p1.succTime;
-		if (e->realNode == NULL)
+		for ( ; k > 0 && e->realNode != NULL ; k--)
+			e->realNode = e->realNode->p0.succStopEmit->p1.succTime;
+		if (k < 0 || e->realNode == NULL)
 		{
 			fprintf(stderr, "ERROR: zone unreachable\n");
 			exit(EXIT_FAILURE);
@@ -4682,9 +7144,9 @@ struct Enforcer *enforcer_new(const struct Graph *g, FILE *logFile, enum
 	}
 
 	initialNode = NULL;
-	for (i = 0 ; i < g->nbNodes ; i++)
+	for (i = 0 ; i < g->nbZones ; i++)
 	{
-		if (g->baseNodes[i]->isInitial)
+		if (g->baseNodes[i] != NULL && g->baseNodes[i]->isInitial)
 		{
 			initialNode = g->baseNodes[i];
 			break;
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <errno.h>
 #include <getopt.h>
 #include <string.h>
 #include <time.h>
@@ -27,7 +28,10 @@ struct Args
 	char *saveFilename;
 	enum FileType fileType;
 	char *filename;
+	char *updateFilename;
 	enum EnforcerMode mode;
+	struct GraphOptions graphOptions;
+	int printStats;
 };
 
 struct InputEvent
@@ -49,6 +53,24 @@ void print_usage(FILE *out, char *progName)
 			"-s, --save-graph=FILE   save the graph to FILE (use it with -g)\n"
 			"-t, --time-file=FILE    save times to FILE\n"
 			"-f, --fast              use fast mode\n"
+			"-j, --threads=N         build the graph with N threads (0: one "
+			"per processor,\n"
+			"                        at most 256)\n"
+			"-r, --parallel-refinement\n"
+			"                        also use the threads to refine the zone "
+			"graph\n"
+			"-S, --stats             print statistics on the construction of "
+			"the graph\n"
+			"-R, --reachable-only    only build and solve the part of the game "
+			"reachable\n"
+			"                        from the initial node\n"
+			"-u, --update=FILE       rebuild the graph for the automaton FILE, a "
+			"modified\n"
+			"                        version of the given one, refining only "
+			"what changed\n"
+			"                        (the zones may differ from the ones of a "
+			"graph built\n"
+			"                        from FILE alone)\n"
 		   );
 }
 
@@ -76,11 +98,37 @@ void initArgs(struct Args *args)
 	args->timeFile = NULL;
 	args->fileType = NONE_FILE;
 	args->filename = NULL;
+	args->updateFilename = NULL;
 	args->mode = ENFORCERMODE_DEFAULT;
+	graphOptions_init(&(args->graphOptions));
+	args->printStats = 0;
 
 	args->logFile = stderr;
 }
 
+/**
+ * Returns the number of threads given to -j, or exits if s is not a number 
+ * between 0 and GRAPHOPTIONS_MAXTHREADS.
+ */
+static unsigned int parseNbThreads(const char *s, char *progName)
+{
+	char *end;
+	long n;
+
+	errno = 0;
+	n = strtol(s, &end, 10);
+	if (errno != 0 || end == s || *end != '\0' || n < 0 || 
+			n > GRAPHOPTIONS_MAXTHREADS)
+	{
+		fprintf(stderr, "Invalid number of threads: %s (between 0 and %d "
+				"expected).\n", s, GRAPHOPTIONS_MAXTHREADS);
+		print_usage(stderr, progName);
+		exit(EXIT_FAILURE);
+	}
+
+	return (unsigned int)n;
+}
+
 int parseArgs(int argc, char *argv[], struct Args *args)
 {
 	int optionIndex;
@@ -95,11 +143,16 @@ int parseArgs(int argc, char *argv[], struct Args *args)
 		{"save-graph", required_argument, NULL, 's'},
 		{"time-file", required_argument, NULL, 't'},
 		{"fast", no_argument, NULL, 'f'},
+		{"threads", required_argument, NULL, 'j'},
+		{"parallel-refinement", no_argument, NULL, 'r'},
+		{"update", required_argument, NULL, 'u'},
+		{"stats", no_argument, NULL, 'S'},
+		{"reachable-only", no_argument, NULL, 'R'},
 		{0, 0, 0, 0}
 	};
 
-	while ((c = getopt_long(argc, argv, "d:z:l:a:g:s:t:f", longOptions, &optionIndex)) != 
-			-1)
+	while ((c = getopt_long(argc, argv, "d:z:l:a:g:s:t:fj:ru:SR", longOptions, 
+					&optionIndex)) != -1)
 	{
 		if (c == 0)
 			c = longOptions[optionIndex].val;
@@ -162,6 +215,27 @@ int parseArgs(int argc, char *argv[], struct Args *args)
 			args->mode = ENFORCERMODE_FAST;
 			break;
 
+			case 'j':
+				args->graphOptions.nbThreads = parseNbThreads(optarg, 
+						argv[0]);
+			break;
+
+			case 'r':
+				args->graphOptions.parallelRefinement = 1;
+			break;
+
+			case 'u':
+				args->updateFilename = optarg;
+			break;
+
+			case 'S':
+				args->printStats = 1;
+			break;
+
+			case 'R':
+				args->graphOptions.reachableOnly = 1;
+			break;
+
 			case '?':
 			break;
 
@@ -238,7 +312,7 @@ int main(int argc, char *argv[])
 	parseArgs(argc, argv, &args);
 
 	if (args.fileType == AUTOMATON_FILE)
-		g = graph_newFromAutomaton(args.filename);
+		g = graph_newFromAutomatonOpts(args.filename, &(args.graphOptions));
 	else if (args.fileType == GRAPH_FILE)
 		g = graph_load(args.filename);
 	else
@@ -247,6 +321,17 @@ int main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
+	if (args.updateFilename != NULL)
+	{
+		struct Graph *g2 = graph_updateFromAutomaton(g, args.updateFilename, 
+				&(args.graphOptions));
+		graph_free(g);
+		g = g2;
+	}
+
+	if (args.printStats)
+		graphStats_print(graph_getStats(g), stderr);
+
 	if (args.drawFile != NULL)
 	{
 		drawGraph(g, args.drawFile);
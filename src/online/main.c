@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <errno.h>
 #include <getopt.h>
 #include <string.h>
 #include <sys/time.h>
@@ -20,6 +21,8 @@ struct Args
 	char *automatonFile;
 	unsigned int pollingTime;
 	enum EnforcerMode mode;
+	struct GraphOptions graphOptions;
+	int printStats;
 };
 
 
@@ -32,6 +35,17 @@ void print_usage(FILE *out, char *progName)
 			"-l, --log-file=FILE     use FILE as log file\n"
 			"-p, --polling=TIME      update the enforcer every TIME ms\n"
 			"-f, --fast              use fast mode\n"
+			"-j, --threads=N         build the graph with N threads (0: one "
+			"per processor,\n"
+			"                        at most 256)\n"
+			"-r, --parallel-refinement\n"
+			"                        also use the threads to refine the zone "
+			"graph\n"
+			"-S, --stats             print statistics on the construction of "
+			"the graph\n"
+			"-R, --reachable-only    only build and solve the part of the game "
+			"reachable\n"
+			"                        from the initial node\n"
 		   );
 }
 
@@ -58,10 +72,35 @@ void initArgs(struct Args *args)
 	args->automatonFile = NULL;
 	args->pollingTime = 0;
 	args->mode = ENFORCERMODE_DEFAULT;
+	graphOptions_init(&(args->graphOptions));
+	args->printStats = 0;
 
 	args->logFile = stderr;
 }
 
+/**
+ * Returns the number of threads given to -j, or exits if s is not a number 
+ * between 0 and GRAPHOPTIONS_MAXTHREADS.
+ */
+static unsigned int parseNbThreads(const char *s, char *progName)
+{
+	char *end;
+	long n;
+
+	errno = 0;
+	n = strtol(s, &end, 10);
+	if (errno != 0 || end == s || *end != '\0' || n < 0 || 
+			n > GRAPHOPTIONS_MAXTHREADS)
+	{
+		fprintf(stderr, "Invalid number of threads: %s (between 0 and %d "
+				"expected).\n", s, GRAPHOPTIONS_MAXTHREADS);
+		print_usage(stderr, progName);
+		exit(EXIT_FAILURE);
+	}
+
+	return (unsigned int)n;
+}
+
 int parseArgs(int argc, char *argv[], struct Args *args)
 {
 	int optionIndex;
@@ -73,11 +112,15 @@ int parseArgs(int argc, char *argv[], struct Args *args)
 		{"log-file", required_argument, NULL, 'l'},
 		{"polling", required_argument, NULL, 'p'},
 		{"fast", no_argument, NULL, 'f'},
+		{"threads", required_argument, NULL, 'j'},
+		{"parallel-refinement", no_argument, NULL, 'r'},
+		{"stats", no_argument, NULL, 'S'},
+		{"reachable-only", no_argument, NULL, 'R'},
 		{0, 0, 0, 0}
 	};
 
-	while ((c = getopt_long(argc, argv, "d:z:l:p:f", longOptions, &optionIndex)) != 
-			-1)
+	while ((c = getopt_long(argc, argv, "d:z:l:p:fj:rSR", longOptions, 
+					&optionIndex)) != -1)
 	{
 		if (c == 0)
 			c = longOptions[optionIndex].val;
@@ -122,6 +165,23 @@ int parseArgs(int argc, char *argv[], struct Args *args)
 				args->mode = ENFORCERMODE_FAST;
 			break;
 
+			case 'j':
+				args->graphOptions.nbThreads = parseNbThreads(optarg, 
+						argv[0]);
+			break;
+
+			case 'r':
+				args->graphOptions.parallelRefinement = 1;
+			break;
+
+			case 'S':
+				args->printStats = 1;
+			break;
+
+			case 'R':
+				args->graphOptions.reachableOnly = 1;
+			break;
+
 			case '?':
 			break;
 
@@ -156,7 +216,9 @@ int main(int argc, char *argv[])
 	initArgs(&args);
 	parseArgs(argc, argv, &args);
 
-	g = graph_newFromAutomaton(args.automatonFile);
+	g = graph_newFromAutomatonOpts(args.automatonFile, &(args.graphOptions));
+	if (args.printStats)
+		graphStats_print(graph_getStats(g), stderr);
 	if (args.drawFile != NULL)
 	{
 		drawGraph(g, args.drawFile);
@@ -250,19 +250,16 @@ void drawGraph(const struct Graph *g, FILE *outFile)
 			exit(EXIT_FAILURE);
 		}
 		n = nviz->n;
-		for (it = listIterator_first(node_edges(n)), i = 0 ; 
-				listIterator_hasNext(it) ; it = listIterator_next(it), i++)
+		for (i = 0 ; i < node_nbEdges(n) ; i++)
 		{
-			struct Edge *e = listIterator_val(it);
-			struct Node *dest = e->succ;
-			Agnode_t *gdest = node_getData(dest);
-			name = edgeName(e, i);
+			struct Edge e = node_edge(n, i);
+			Agnode_t *gdest = node_getData(e.succ);
+			name = edgeName(&e, i);
 			gedge = agedge(gviz, gnode, gdest, name, TRUE);
 			free(name);
-			agset(gedge, "color", colors[e->type]);
-			agset(gedge, "arrowhead", arrowheads[e->type]);
+			agset(gedge, "color", colors[e.type]);
+			agset(gedge, "arrowhead", arrowheads[e.type]);
 		}
-		listIterator_release(it);
 	}
 	gvc = gvContext();
 	gvLayout(gvc, gviz, "dot");
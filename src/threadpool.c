@@ -0,0 +1,184 @@
+#include "threadpool.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+struct Worker
+{
+	struct ThreadPool *pool;
+	unsigned int index;
+	pthread_t thread;
+};
+
+struct ThreadPool
+{
+	unsigned int nbThreads;
+	/* Worker 0 is the thread calling threadPool_run */
+	struct Worker *workers;
+	pthread_mutex_t mutex;
+	pthread_cond_t start;
+	pthread_cond_t done;
+	unsigned long generation;
+	unsigned int nbRunning;
+	int quit;
+	/* Current job */
+	ThreadPoolFunc f;
+	void *arg;
+	unsigned int n;
+};
+
+static void threadPool_runSlice(struct ThreadPool *pool, unsigned int worker)
+{
+	unsigned int begin, end;
+
+	begin = (unsigned int)((unsigned long)pool->n * worker / pool->nbThreads);
+	end = (unsigned int)((unsigned long)pool->n * (worker + 1) /
+			pool->nbThreads);
+	if (begin < end)
+		pool->f(pool->arg, begin, end, worker);
+}
+
+static void *worker_main(void *p)
+{
+	struct Worker *w = p;
+	struct ThreadPool *pool = w->pool;
+	unsigned long generation = 0;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&(pool->mutex));
+		while (!pool->quit && pool->generation == generation)
+			pthread_cond_wait(&(pool->start), &(pool->mutex));
+		if (pool->quit)
+		{
+			pthread_mutex_unlock(&(pool->mutex));
+			break;
+		}
+		generation = pool->generation;
+		pthread_mutex_unlock(&(pool->mutex));
+
+		threadPool_runSlice(pool, w->index);
+
+		pthread_mutex_lock(&(pool->mutex));
+		pool->nbRunning--;
+		if (pool->nbRunning == 0)
+			pthread_cond_signal(&(pool->done));
+		pthread_mutex_unlock(&(pool->mutex));
+	}
+
+	return NULL;
+}
+
+/**
+ * Creates a pool of nbThreads threads (including the calling thread). If
+ * nbThreads is 0, one thread per online processor is used.
+ */
+struct ThreadPool *threadPool_new(unsigned int nbThreads)
+{
+	unsigned int i;
+	struct ThreadPool *pool = malloc(sizeof *pool);
+
+	if (pool == NULL)
+	{
+		perror("malloc threadPool_new:pool");
+		exit(EXIT_FAILURE);
+	}
+
+	if (nbThreads == 0)
+	{
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		nbThreads = (n > 0) ? (unsigned int)n : 1;
+	}
+
+	pool->nbThreads = nbThreads;
+	pool->generation = 0;
+	pool->nbRunning = 0;
+	pool->quit = 0;
+	pool->f = NULL;
+	pool->arg = NULL;
+	pool->n = 0;
+	pthread_mutex_init(&(pool->mutex), NULL);
+	pthread_cond_init(&(pool->start), NULL);
+	pthread_cond_init(&(pool->done), NULL);
+
+	pool->workers = malloc(nbThreads * sizeof *(pool->workers));
+	if (pool->workers == NULL)
+	{
+		perror("malloc threadPool_new:pool->workers");
+		exit(EXIT_FAILURE);
+	}
+	for (i = 0 ; i < nbThreads ; i++)
+	{
+		pool->workers[i].pool = pool;
+		pool->workers[i].index = i;
+		if (i == 0)
+			continue;
+		if (pthread_create(&(pool->workers[i].thread), NULL, worker_main,
+					&(pool->workers[i])) != 0)
+		{
+			perror("pthread_create threadPool_new");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	return pool;
+}
+
+unsigned int threadPool_nbThreads(const struct ThreadPool *pool)
+{
+	return pool->nbThreads;
+}
+
+/**
+ * Splits [0, n) into one contiguous slice per thread and calls f on each slice
+ * in parallel. Returns when all the slices have been processed.
+ */
+void threadPool_run(struct ThreadPool *pool, unsigned int n, ThreadPoolFunc f,
+		void *arg)
+{
+	if (pool->nbThreads == 1 || n <= 1)
+	{
+		if (n > 0)
+			f(arg, 0, n, 0);
+		return;
+	}
+
+	pthread_mutex_lock(&(pool->mutex));
+	pool->f = f;
+	pool->arg = arg;
+	pool->n = n;
+	pool->nbRunning = pool->nbThreads - 1;
+	pool->generation++;
+	pthread_cond_broadcast(&(pool->start));
+	pthread_mutex_unlock(&(pool->mutex));
+
+	threadPool_runSlice(pool, 0);
+
+	pthread_mutex_lock(&(pool->mutex));
+	while (pool->nbRunning > 0)
+		pthread_cond_wait(&(pool->done), &(pool->mutex));
+	pthread_mutex_unlock(&(pool->mutex));
+}
+
+void threadPool_free(struct ThreadPool *pool)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&(pool->mutex));
+	pool->quit = 1;
+	pthread_cond_broadcast(&(pool->start));
+	pthread_mutex_unlock(&(pool->mutex));
+
+	for (i = 1 ; i < pool->nbThreads ; i++)
+		pthread_join(pool->workers[i].thread, NULL);
+
+	pthread_mutex_destroy(&(pool->mutex));
+	pthread_cond_destroy(&(pool->start));
+	pthread_cond_destroy(&(pool->done));
+	free(pool->workers);
+	free(pool);
+}
+
@@ -0,0 +1,583 @@
+/*
+ * Checks of the DBM kernels of src/dbmutils.c against the results of the
+ * generic udbm functions. The file is included, so that its static functions
+ * can be called.
+ */
+#include "../../../src/dbmutils.c"
+
+/* Only used by dbmw_print */
+struct Clock **clocks = NULL;
+
+/* Greatest constant of the clocks in the checked points */
+#define CHECK_MAXVAL	20
+/* Biggest dimension of the random DBMs, enough for two AVX2 vectors and a 
+ * scalar tail */
+#define CHECK_MAXDIM	17
+/* Number of random cases per dimension */
+#define CHECK_NBCASES	2000
+/* Number of DBMs given to dbmw_firstIncluding */
+#define CHECK_NBDBMS	8
+/* Number of threads sharing a DbmwTable, of DBMs they intern, and of 
+ * operations of each thread */
+#define CHECK_NBTHREADS	4
+#define CHECK_NBTABLEDBMS	16
+#define CHECK_NBTABLEOPS	20000
+
+static unsigned int nbFailures = 0;
+/* State of check_rand, fixed so that the cases are the same for every run */
+static uint32_t randState = 1;
+
+static void check(int cond, const char *what)
+{
+	if (!cond)
+	{
+		fprintf(stderr, "FAILED: %s\n", what);
+		nbFailures++;
+	}
+}
+
+/**
+ * Returns a pseudo-random integer in [0, n).
+ */
+static int32_t check_rand(int32_t n)
+{
+	randState = randState * 1103515245 + 12345;
+
+	return (int32_t)((randState >> 16) % (uint32_t)n);
+}
+
+/**
+ * Writes into dbm a random closed DBM that is not empty, made of a few random 
+ * constraints.
+ */
+static void check_randomDbm(raw_t *dbm, cindex_t dim)
+{
+	raw_t save[CHECK_MAXDIM * CHECK_MAXDIM];
+	unsigned int k;
+
+	dbm_init(dbm, dim);
+	for (k = 0 ; k < 2 * dim ; k++)
+	{
+		cindex_t i = check_rand(dim), j = check_rand(dim);
+		raw_t c = dbm_bound2raw(check_rand(2 * CHECK_MAXVAL + 1) - 
+				CHECK_MAXVAL, check_rand(2) ? dbm_STRICT : dbm_WEAK);
+
+		if (i == j)
+			continue;
+		dbm_copy(save, dbm, dim);
+		if (!dbm_constrain1(dbm, dim, i, j, c))
+			dbm_copy(dbm, save, dim);
+	}
+}
+
+static void check_randomPoint(int32_t *val, cindex_t dim)
+{
+	cindex_t i;
+
+	val[0] = 0;
+	for (i = 1 ; i < dim ; i++)
+		val[i] = check_rand(CHECK_MAXVAL + 5);
+}
+
+/**
+ * Returns 1 iff a and b are both empty, or are equal.
+ */
+static int check_sameDbm(const raw_t *a, const raw_t *b, cindex_t dim)
+{
+	if (a[0] < dbm_LE_ZERO || b[0] < dbm_LE_ZERO)
+		return a[0] < dbm_LE_ZERO && b[0] < dbm_LE_ZERO;
+
+	return dbm_areEqual(a, b, dim);
+}
+
+/**
+ * Compares each dbmSmall_* kernel with the udbm function it replaces, on 
+ * random DBMs of dimension dim (2 or 3).
+ */
+static void check_dbmSmall(cindex_t dim)
+{
+	raw_t a[CHECK_MAXDIM * CHECK_MAXDIM], b[CHECK_MAXDIM * CHECK_MAXDIM];
+	raw_t small[CHECK_MAXDIM * CHECK_MAXDIM], generic[CHECK_MAXDIM * 
+		CHECK_MAXDIM];
+	int32_t val[CHECK_MAXDIM];
+	int ok[7] = {1, 1, 1, 1, 1, 1, 1};
+	unsigned int n;
+	cindex_t i, j, k;
+
+	for (n = 0 ; n < CHECK_NBCASES ; n++)
+	{
+		check_randomDbm(a, dim);
+		check_randomDbm(b, dim);
+
+		/* An entry is tightened without closing the DBM */
+		i = check_rand(dim);
+		j = check_rand(dim);
+		dbm_copy(small, a, dim);
+		if (i != j)
+		{
+			small[i * dim + j] = dbm_bound2raw(check_rand(2 * CHECK_MAXVAL + 
+						1) - CHECK_MAXVAL, dbm_WEAK);
+		}
+		dbm_copy(generic, small, dim);
+		if (dbmSmall_close(small, dim) != (dbm_close(generic, dim) != 0) || 
+				!check_sameDbm(small, generic, dim))
+			ok[0] = 0;
+
+		dbm_copy(small, a, dim);
+		dbm_copy(generic, a, dim);
+		if (dbmSmall_intersection(small, b, dim) != (dbm_intersection(generic, 
+						b, dim) != 0) || !check_sameDbm(small, generic, dim))
+			ok[1] = 0;
+
+		if (dbmSmall_isSubsetEq(a, b, dim) != (dbm_isSubsetEq(a, b, dim) != 0)
+				|| dbmSmall_isSubsetEq(a, a, dim) != 1)
+			ok[2] = 0;
+
+		dbm_copy(small, a, dim);
+		dbm_copy(generic, a, dim);
+		dbmSmall_up(small, dim);
+		dbm_up(generic, dim);
+		if (!check_sameDbm(small, generic, dim))
+			ok[3] = 0;
+
+		dbm_copy(small, a, dim);
+		dbm_copy(generic, a, dim);
+		dbmSmall_down(small, dim);
+		dbm_down(generic, dim);
+		if (!check_sameDbm(small, generic, dim))
+			ok[4] = 0;
+
+		k = 1 + check_rand(dim - 1);
+		dbm_copy(small, a, dim);
+		dbm_copy(generic, a, dim);
+		dbmSmall_reset(small, dim, k);
+		dbm_updateValue(generic, dim, k, 0);
+		if (!check_sameDbm(small, generic, dim))
+			ok[5] = 0;
+
+		check_randomPoint(val, dim);
+		if (dbmSmall_isPointIncluded(val, a, dim) != 
+				(dbm_isPointIncluded(val, a, dim) != 0))
+			ok[6] = 0;
+	}
+
+	check(ok[0], "dbmSmall_close is dbm_close");
+	check(ok[1], "dbmSmall_intersection is dbm_intersection");
+	check(ok[2], "dbmSmall_isSubsetEq is dbm_isSubsetEq");
+	check(ok[3], "dbmSmall_up is dbm_up");
+	check(ok[4], "dbmSmall_down is dbm_down");
+	check(ok[5], "dbmSmall_reset is dbm_updateValue to 0");
+	check(ok[6], "dbmSmall_isPointIncluded is dbm_isPointIncluded");
+}
+
+/**
+ * Compares dbmw_firstIncluding with the first of the DBMs that includes the 
+ * point according to dbm_isPointIncluded.
+ */
+static void check_firstIncluding(cindex_t dim)
+{
+	struct Dbmw *dbms[CHECK_NBDBMS];
+	int32_t val[CHECK_MAXDIM];
+	unsigned int n, k;
+	int ok = 1;
+
+	for (k = 0 ; k < CHECK_NBDBMS ; k++)
+		dbms[k] = dbmw_new(dim);
+
+	for (n = 0 ; n < CHECK_NBCASES ; n++)
+	{
+		int expected = -1;
+
+		if (n % 16 == 0)
+		{
+			for (k = 0 ; k < CHECK_NBDBMS ; k++)
+				check_randomDbm(dbms[k]->dbm, dim);
+		}
+		check_randomPoint(val, dim);
+		for (k = 0 ; k < CHECK_NBDBMS && expected < 0 ; k++)
+		{
+			if (dbm_isPointIncluded(val, dbms[k]->dbm, dim))
+				expected = k;
+		}
+		if (dbmw_firstIncluding((const struct Dbmw *const *)dbms, 
+					CHECK_NBDBMS, val) != expected)
+			ok = 0;
+	}
+	check(ok, "dbmw_firstIncluding gives the first DBM including the point");
+
+	for (k = 0 ; k < CHECK_NBDBMS ; k++)
+		dbmw_free(dbms[k]);
+}
+
+/**
+ * Writes into dbm a random closed DBM made of constraints on the differences 
+ * of val, each loosened by at most 2, so that val is in it.
+ */
+static void check_dbmAround(raw_t *dbm, const int32_t *val, cindex_t dim)
+{
+	raw_t save[CHECK_MAXDIM * CHECK_MAXDIM];
+	unsigned int k;
+
+	dbm_init(dbm, dim);
+	for (k = 0 ; k < 2 * dim ; k++)
+	{
+		cindex_t i = check_rand(dim), j = check_rand(dim);
+		int32_t slack = check_rand(3);
+		raw_t c = dbm_bound2raw(val[i] - val[j] + slack, (slack > 0 && 
+					check_rand(2)) ? dbm_STRICT : dbm_WEAK);
+
+		if (i == j)
+			continue;
+		dbm_copy(save, dbm, dim);
+		if (!dbm_constrain1(dbm, dim, i, j, c))
+			dbm_copy(dbm, save, dim);
+	}
+}
+
+/**
+ * Compares the kernels on valuations, which use AVX2 or SSE2 when they are 
+ * enabled, with the scalar computations, on random DBMs of dimension dim: 
+ * dbmw_isPointIncluded with dbm_isPointIncluded, and dbmw_distance with the 
+ * greatest distance of the point to the lower bounds of the clocks.
+ */
+static void check_valuationKernels(cindex_t dim)
+{
+	struct Dbmw *d = dbmw_new(dim);
+	int32_t val[CHECK_MAXDIM];
+	unsigned int n, nbIncluded = 0;
+	int okIncluded = 1, okDistance = 1;
+	char what[64];
+
+	for (n = 0 ; n < CHECK_NBCASES ; n++)
+	{
+		int expected = 0, isBelow = 1;
+		cindex_t i;
+
+		check_randomPoint(val, dim);
+		check_dbmAround(d->dbm, val, dim);
+		if (n % 2 == 1)
+		{
+			/* Another point, which may be out of the DBM */
+			i = 1 + check_rand(dim - 1);
+			val[i] = check_rand(CHECK_MAXVAL + 5);
+		}
+
+		if (dbm_isPointIncluded(val, d->dbm, dim))
+			nbIncluded++;
+		if (dbmw_isPointIncluded(d, val) != dbm_isPointIncluded(val, d->dbm, 
+					dim))
+			okIncluded = 0;
+
+		for (i = 1 ; i < dim ; i++)
+		{
+			int dist = -dbm_raw2bound(d->dbm[i]) - val[i] + 
+				(dbm_rawIsStrict(d->dbm[i]) ? 1 : 0);
+
+			expected = (dist > expected) ? dist : expected;
+			if (val[i] > dbm_raw2bound(d->dbm[i * dim]))
+				isBelow = 0;
+		}
+		if (dbmw_maxLowerDistance(d->dbm, val, dim) != expected || (isBelow && 
+					dbmw_distance(val, d) != (unsigned int)expected))
+			okDistance = 0;
+	}
+
+	sprintf(what, "dbmw_isPointIncluded, dimension %u", dim);
+	check(okIncluded && nbIncluded > 0 && nbIncluded < CHECK_NBCASES, what);
+	sprintf(what, "dbmw_distance, dimension %u", dim);
+	check(okDistance, what);
+
+	dbmw_free(d);
+}
+
+/**
+ * Returns the number of DBMs of f that include the point val.
+ */
+static unsigned int fed_nbIncluding(const struct Fed *f, const int32_t *val)
+{
+	unsigned int i, n = 0;
+
+	for (i = 0 ; i < f->size ; i++)
+	{
+		if (dbm_isPointIncluded(val, &(f->dbms[i * f->dim * f->dim]), f->dim))
+			n++;
+	}
+
+	return n;
+}
+
+/**
+ * Subtracts from the whole plane the zone x = 10 /\ x - y <= 0 /\ y >= 10,
+ * whose minimal representation goes through the zero cycle 0 -> x -> 0. The
+ * pieces must be disjoint and cover every point outside of the zone.
+ */
+static void check_subtractZeroCycle(void)
+{
+	struct Fed *f = fed_new(3);
+	struct Dbmw *z0 = dbmw_new(3), *z1 = dbmw_new(3);
+	int32_t val[3] = {0, 0, 0};
+	int ok = 1;
+
+	dbm_constrain1(z1->dbm, 3, 1, 0, dbm_bound2raw(10, dbm_WEAK));
+	dbm_constrain1(z1->dbm, 3, 0, 1, dbm_bound2raw(-10, dbm_WEAK));
+	dbm_constrain1(z1->dbm, 3, 1, 2, dbm_bound2raw(0, dbm_WEAK));
+	dbm_constrain1(z1->dbm, 3, 0, 2, dbm_bound2raw(-10, dbm_WEAK));
+
+	fed_append(f, z0);
+	fed_subtract(f, z1);
+	check(fed_size(f) == 3, "subtraction of a zero cycle: 3 pieces");
+
+	for (val[1] = 0 ; val[1] <= CHECK_MAXVAL ; val[1]++)
+	{
+		for (val[2] = 0 ; val[2] <= CHECK_MAXVAL ; val[2]++)
+		{
+			unsigned int expected = !dbm_isPointIncluded(val, z1->dbm, 3);
+			if (fed_nbIncluding(f, val) != expected)
+				ok = 0;
+		}
+	}
+	check(ok, "subtraction of a zero cycle: pieces partition the difference");
+
+	dbmw_free(z0);
+	dbmw_free(z1);
+	fed_free(f);
+}
+
+/**
+ * Returns a new DBM of dimension 3 for lx <= x <= ux /\ ly <= y <= uy.
+ */
+static struct Dbmw *check_box(int32_t lx, int32_t ux, int32_t ly, int32_t uy)
+{
+	struct Dbmw *d = dbmw_new(3);
+
+	dbm_constrain1(d->dbm, 3, 0, 1, dbm_bound2raw(-lx, dbm_WEAK));
+	dbm_constrain1(d->dbm, 3, 1, 0, dbm_bound2raw(ux, dbm_WEAK));
+	dbm_constrain1(d->dbm, 3, 0, 2, dbm_bound2raw(-ly, dbm_WEAK));
+	dbm_constrain1(d->dbm, 3, 2, 0, dbm_bound2raw(uy, dbm_WEAK));
+
+	return d;
+}
+
+/**
+ * Merges the four quadrants of a square, with and without classes, then 
+ * merges the pieces of the partition of random DBMs: the pieces must still be 
+ * disjoint, cover the same points, and be included in each DBM of the 
+ * partition or disjoint from it.
+ */
+static void check_mergeAdjacent(void)
+{
+	struct Fed *f = fed_new(3), *classes = fed_new(3);
+	struct Dbmw *quadrants[4], *square = check_box(0, 10, 0, 10);
+	struct Dbmw *left = check_box(0, 5, 0, 10), *d = dbmw_new(3);
+	raw_t tmp[9];
+	int32_t val[3] = {0, 0, 0};
+	unsigned int n, i, k;
+	int ok = 1;
+
+	quadrants[0] = check_box(0, 5, 0, 5);
+	quadrants[1] = check_box(0, 5, 5, 10);
+	quadrants[2] = check_box(5, 10, 0, 5);
+	quadrants[3] = check_box(5, 10, 5, 10);
+	for (k = 0 ; k < 4 ; k++)
+		fed_append(f, quadrants[k]);
+	fed_partition(f);
+	fed_mergeAdjacent(f, NULL);
+	check(fed_size(f) == 1 && dbm_areEqual(f->dbms, square->dbm, 3), 
+			"merge of the quadrants of a square: the square");
+
+	fed_clear(f);
+	fed_append(classes, square);
+	fed_append(classes, left);
+	for (k = 0 ; k < 4 ; k++)
+		fed_append(f, quadrants[k]);
+	fed_partition(f);
+	fed_mergeAdjacent(f, classes);
+	check(fed_size(f) == 2, "merge of the quadrants of a square, with its left "
+			"half as class: 2 halves");
+
+	for (n = 0 ; n < CHECK_NBCASES / 16 ; n++)
+	{
+		fed_clear(f);
+		fed_clear(classes);
+		for (k = 0 ; k < CHECK_NBDBMS ; k++)
+		{
+			check_randomDbm(d->dbm, 3);
+			fed_append(classes, d);
+		}
+		fed_union(f, classes);
+		fed_partition(f);
+		i = fed_size(f);
+		fed_mergeAdjacent(f, classes);
+		if (fed_size(f) > i)
+			ok = 0;
+
+		for (i = 0 ; i < fed_size(f) ; i++)
+		{
+			const raw_t *piece = &(f->dbms[i * 9]);
+			for (k = 0 ; k < CHECK_NBDBMS ; k++)
+			{
+				const raw_t *c = &(classes->dbms[k * 9]);
+				dbm_copy(tmp, piece, 3);
+				if (!dbm_isSubsetEq(piece, c, 3) && dbm_intersection(tmp, c, 3))
+					ok = 0;
+			}
+		}
+
+		for (val[1] = 0 ; val[1] <= CHECK_MAXVAL ; val[1]++)
+		{
+			for (val[2] = 0 ; val[2] <= CHECK_MAXVAL ; val[2]++)
+			{
+				unsigned int expected = (fed_nbIncluding(classes, val) > 0);
+				if (fed_nbIncluding(f, val) != expected)
+					ok = 0;
+			}
+		}
+	}
+	check(ok, "merged pieces of a partition still partition the DBMs");
+
+	for (k = 0 ; k < 4 ; k++)
+		dbmw_free(quadrants[k]);
+	dbmw_free(square);
+	dbmw_free(left);
+	dbmw_free(d);
+	fed_free(f);
+	fed_free(classes);
+}
+
+/* Argument of check_dbmwTableThread */
+struct CheckTableArg
+{
+	struct DbmwTable *t;
+	/* The DBMs to intern. The first half of them is interned by 
+	 * check_dbmwTable before the threads start, as witnesses. */
+	const raw_t *dbms;
+	const struct Dbmw **witnesses;
+	uint32_t randState;
+	unsigned int nbFailures;
+};
+
+static void *check_dbmwTableThread(void *parg)
+{
+	struct CheckTableArg *arg = parg;
+	const struct Dbmw *held[CHECK_NBTABLEDBMS] = {NULL};
+	unsigned int i, k;
+
+	for (i = 0 ; i < CHECK_NBTABLEOPS ; i++)
+	{
+		struct Dbmw *d;
+		const struct Dbmw *p;
+
+		arg->randState = arg->randState * 1103515245 + 12345;
+		k = (arg->randState >> 16) % CHECK_NBTABLEDBMS;
+		if (held[k] != NULL)
+		{
+			dbmwTable_release(arg->t, held[k]);
+			held[k] = NULL;
+			continue;
+		}
+
+		d = dbmw_new(3);
+		memcpy(d->dbm, &(arg->dbms[k * 9]), 9 * sizeof *(d->dbm));
+		p = dbmwTable_intern(arg->t, d);
+		if (!dbm_areEqual(p->dbm, &(arg->dbms[k * 9]), 3) || 
+				(k < CHECK_NBTABLEDBMS / 2 && p != arg->witnesses[k]) || 
+				dbmw_areEqual(p, arg->witnesses[k % (CHECK_NBTABLEDBMS / 
+						2)]) != (k < CHECK_NBTABLEDBMS / 2))
+			arg->nbFailures++;
+		held[k] = dbmwTable_ref(arg->t, p);
+		dbmwTable_release(arg->t, p);
+	}
+
+	for (k = 0 ; k < CHECK_NBTABLEDBMS ; k++)
+	{
+		if (held[k] != NULL)
+			dbmwTable_release(arg->t, held[k]);
+	}
+	dbmw_releasePool();
+
+	return NULL;
+}
+
+/**
+ * Several threads intern, reference and release the same DBMs of a table, 
+ * while comparing them with dbmw_areEqual. Interning a DBM must give the DBM 
+ * of the table equal to it, and the table must be empty once all is released.
+ */
+static void check_dbmwTable(void)
+{
+	struct DbmwTable *t = dbmwTable_new();
+	raw_t dbms[CHECK_NBTABLEDBMS * 9];
+	const struct Dbmw *witnesses[CHECK_NBTABLEDBMS / 2];
+	struct CheckTableArg args[CHECK_NBTHREADS];
+	pthread_t threads[CHECK_NBTHREADS];
+	unsigned int i, k;
+
+	/* Pairwise different DBMs: x <= k */
+	for (k = 0 ; k < CHECK_NBTABLEDBMS ; k++)
+	{
+		dbm_init(&(dbms[k * 9]), 3);
+		dbm_constrain1(&(dbms[k * 9]), 3, 1, 0, dbm_bound2raw(k, dbm_WEAK));
+	}
+	for (k = 0 ; k < CHECK_NBTABLEDBMS / 2 ; k++)
+	{
+		struct Dbmw *d = dbmw_new(3);
+		memcpy(d->dbm, &(dbms[k * 9]), 9 * sizeof *(d->dbm));
+		witnesses[k] = dbmwTable_intern(t, d);
+	}
+
+	for (i = 0 ; i < CHECK_NBTHREADS ; i++)
+	{
+		args[i].t = t;
+		args[i].dbms = dbms;
+		args[i].witnesses = witnesses;
+		args[i].randState = i + 1;
+		args[i].nbFailures = 0;
+		if (pthread_create(&(threads[i]), NULL, check_dbmwTableThread, 
+					&(args[i])) != 0)
+		{
+			perror("pthread_create check_dbmwTable");
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (i = 0 ; i < CHECK_NBTHREADS ; i++)
+	{
+		pthread_join(threads[i], NULL);
+		check(args[i].nbFailures == 0, "dbmwTable_intern, concurrent");
+	}
+
+	check(dbmwTable_size(t) == CHECK_NBTABLEDBMS / 2, 
+			"dbmwTable_size, concurrent");
+	for (k = 0 ; k < CHECK_NBTABLEDBMS / 2 ; k++)
+		dbmwTable_release(t, witnesses[k]);
+	check(dbmwTable_size(t) == 0, "dbmwTable_release");
+	dbmwTable_free(t);
+}
+
+int main(void)
+{
+	check_dbmwTable();
+	check_subtractZeroCycle();
+	check_mergeAdjacent();
+	check_dbmSmall(2);
+	check_dbmSmall(3);
+	check_firstIncluding(2);
+	check_firstIncluding(3);
+	check_firstIncluding(5);
+	check_firstIncluding(CHECK_MAXDIM);
+	check_valuationKernels(4);
+	check_valuationKernels(5);
+	check_valuationKernels(8);
+	check_valuationKernels(9);
+	check_valuationKernels(12);
+	check_valuationKernels(CHECK_MAXDIM);
+
+	dbmw_releasePool();
+	if (nbFailures > 0)
+	{
+		fprintf(stderr, "%u check(s) failed.\n", nbFailures);
+		return EXIT_FAILURE;
+	}
+	printf("All checks passed.\n");
+
+	return EXIT_SUCCESS;
+}
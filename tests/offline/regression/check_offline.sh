@@ -0,0 +1,139 @@
+#!/bin/bash
+# Regression checks of the offline enforcer on the bundled automata, and on
+# safety_large.tmtn, whose graph is big enough for the thread pool to split
+# the attractors, and safety_phases.tmtn. For each automaton, the size of its
+# graph and the summary of the enforcer on the trace of traces/ are compared
+# with the ones of expected/, in the default and in the fast mode. They must be
+# the same when the graph is built with several threads, also when the zone
+# graph is refined on these threads (-r), and the summary must be the same when
+# only the reachable part of the game is built (-R).
+# Each automaton of edited/ is the one of the same name with some guards
+# changed. The graph updated from the one of the original automaton (-u) must
+# give the same summary as the graph built from scratch. Its zones may differ,
+# so its size is compared with expected/ only. For the automata of
+# IncrementalModels, the edit only concerns a few states, and the update must
+# perform fewer operations on DBMs than the build from scratch.
+# Run it from this directory, once game_enf_offline is built (or set Prog).
+
+Prog="${Prog:-../game_enf_offline}"
+TracesDir="traces"
+ExpectedDir="expected"
+EditedDir="edited"
+OutDir="out"
+Models="cosafety odd propInfZg propPaper response safety safety_two_clocks
+	safety_large safety_phases"
+IncrementalModels="cosafety safety_phases"
+NbThreads=4
+
+NbFailures=0
+
+# automaton Model
+# Prints the file of the automaton Model.
+automaton() {
+	if [ -f $1.tmtn ]; then
+		echo $1.tmtn
+	else
+		echo ../$1.tmtn
+	fi
+}
+
+# run Automaton Model OutFile [options...]
+# Writes to OutFile the numbers of zones and nodes of the graph of Automaton,
+# and the summary of the enforcer on the trace of Model, and to OutFile.stderr
+# all that the enforcer printed on stderr. The enforcer must exit successfully.
+run() {
+	local Automaton=$1
+	local Model=$2
+	local OutFile=$3
+	local Status
+	shift 3
+
+	$Prog -S -a $Automaton "$@" <$TracesDir/$Model 2>$OutFile.stderr \
+		>/dev/null
+	Status=$?
+	if [ $Status -ne 0 ]; then
+		echo "FAILED: $Automaton${*:+ $*}, exit status $Status"
+		NbFailures=$((NbFailures + 1))
+	fi
+	sed -n -e 's/^\(graph: [0-9]* zones\).*, \([0-9]* nodes\),.*/\1, \2/p' \
+		-e '/^\(Input\|Output\|Remaining events in the buffer\|VERDICT\):/p' \
+		$OutFile.stderr >$OutFile
+}
+
+# nbDbmOps OutFile
+# Prints the number of operations on DBMs performed to build the graph of a
+# run.
+nbDbmOps() {
+	sed -n -e 's/^total  *[0-9.]*  *[0-9.]*  *\([0-9]*\)$/\1/p' $1.stderr
+}
+
+# compare Name File1 File2
+compare() {
+	if ! diff -q $2 $3 >/dev/null; then
+		echo "FAILED: $1"
+		diff $2 $3
+		NbFailures=$((NbFailures + 1))
+	fi
+}
+
+# compareSummaries Name File1 File2
+# Same as compare, without the sizes of the graphs.
+compareSummaries() {
+	grep -v '^graph:' $2 >$2.summary
+	grep -v '^graph:' $3 >$3.summary
+	compare "$1" $2.summary $3.summary
+}
+
+mkdir -p $OutDir
+
+for Model in $Models; do
+	Automaton=$(automaton $Model)
+
+	run $Automaton $Model $OutDir/$Model
+	compare "$Model" $ExpectedDir/$Model $OutDir/$Model
+	run $Automaton $Model $OutDir/$Model.fast -f
+	compare "$Model, fast mode" $ExpectedDir/$Model.fast $OutDir/$Model.fast
+
+	run $Automaton $Model $OutDir/$Model.j$NbThreads -j $NbThreads
+	compare "$Model, $NbThreads threads" $OutDir/$Model \
+		$OutDir/$Model.j$NbThreads
+	run $Automaton $Model $OutDir/$Model.r$NbThreads -j $NbThreads -r
+	compare "$Model, $NbThreads threads, parallel refinement" $OutDir/$Model \
+		$OutDir/$Model.r$NbThreads
+
+	run $Automaton $Model $OutDir/$Model.reachable -R
+	compareSummaries "$Model, reachable only" $OutDir/$Model \
+		$OutDir/$Model.reachable
+	run $Automaton $Model $OutDir/$Model.reachable.fast -R -f
+	compareSummaries "$Model, reachable only, fast mode" $OutDir/$Model.fast \
+		$OutDir/$Model.reachable.fast
+done
+
+for Edited in $EditedDir/*.tmtn; do
+	Model=$(basename $Edited .tmtn)
+
+	run $Edited $Model $OutDir/$Model.scratch
+	run $(automaton $Model) $Model $OutDir/$Model.update -u $Edited
+	compare "$Model, updated" $ExpectedDir/$Model.update $OutDir/$Model.update
+	compareSummaries "$Model, updated and built from scratch" \
+		$OutDir/$Model.scratch $OutDir/$Model.update
+done
+
+for Model in $IncrementalModels; do
+	ScratchOps=$(nbDbmOps $OutDir/$Model.scratch)
+	UpdateOps=$(nbDbmOps $OutDir/$Model.update)
+	if [ -z "$ScratchOps" ] || [ -z "$UpdateOps" ] || \
+			[ $UpdateOps -ge $ScratchOps ]; then
+		echo "FAILED: $Model, update cheaper than a build from scratch"
+		echo "$UpdateOps DBM operations, $ScratchOps from scratch"
+		NbFailures=$((NbFailures + 1))
+	fi
+done
+
+if [ $NbFailures -gt 0 ]; then
+	echo "$NbFailures check(s) failed."
+	exit 1
+fi
+echo "All checks passed."
+
+exit 0